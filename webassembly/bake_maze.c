@@ -0,0 +1,125 @@
+// Host-side generator for maze_baked.h: runs the runtime maze builder from
+// graphics.c and prints its wall table (bounds, face masks, baked occlusion)
+// and collision grid as const C data, so the wasm module starts with the scene
+// already built.
+//
+//   bake_maze          write the header to stdout
+//   bake_maze --check  (built with -DMAZE_BAKED) compare the compiled-in
+//                      tables against a fresh runtime build, exit 1 on drift
+#include "graphics.c"
+
+#include <stdio.h>
+#include <string.h>
+
+// Shortest decimal that reads back as the same float, always as a valid
+// float literal ("2.0f", not "2f").
+static void printFloat(float v) {
+  char text[32];
+  int digits;
+  for (digits = 6; digits < 10; digits++) {
+    snprintf(text, sizeof(text), "%.*g", digits, (double)v);
+    float back;
+    sscanf(text, "%f", &back);
+    if (back == v)
+      break;
+  }
+  if (!strpbrk(text, ".en"))
+    strcat(text, ".0");
+  printf("%sf", text);
+}
+
+static void emitHeader(const Wall *walls, int count,
+                       short grid[MAZE_H][MAZE_W]) {
+  int i, f, k, r, c;
+  printf("// Generated by bake_maze from MAZE in graphics.c. Do not edit;\n"
+         "// run `make maze_baked.h` after changing the maze or builder.\n");
+  printf("#define BAKED_WALL_COUNT %d\n\n", count);
+  printf("static const Wall BAKED_WALLS[%d] = {\n", count > 0 ? count : 1);
+  for (i = 0; i < count; i++) {
+    const Wall *w = &walls[i];
+    printf("    {");
+    printFloat(w->minx);
+    printf(", ");
+    printFloat(w->minz);
+    printf(", ");
+    printFloat(w->maxx);
+    printf(", ");
+    printFloat(w->maxz);
+    printf(", ");
+    printFloat(w->height);
+    printf(", 0x%08xu, 0x%02xu,\n     {", w->color, w->visible_faces);
+    for (f = 0; f < 6; f++) {
+      if (f == 3)
+        printf("\n      ");
+      printf("{");
+      for (k = 0; k < 4; k++)
+        printf(k ? ", %u" : "%u", w->ao[f][k]);
+      printf(f == 5 ? "}" : f == 2 ? "}," : "}, ");
+    }
+    printf("}},\n");
+  }
+  printf("};\n\n");
+  printf("static const short BAKED_WALL_GRID[%d][%d] = {\n", MAZE_H, MAZE_W);
+  for (r = 0; r < MAZE_H; r++) {
+    printf("    {");
+    for (c = 0; c < MAZE_W; c++)
+      printf(c ? ", %d" : "%d", grid[r][c]);
+    printf("},\n");
+  }
+  printf("};\n");
+}
+
+#ifdef MAZE_BAKED
+static int checkBaked(const Wall *walls, int count,
+                      short grid[MAZE_H][MAZE_W]) {
+  int errors = 0;
+  int i, r, c;
+  if (count != BAKED_WALL_COUNT) {
+    fprintf(stderr, "wall count: baked %d, runtime %d\n", BAKED_WALL_COUNT,
+            count);
+    return 1;
+  }
+  for (i = 0; i < count; i++) {
+    const Wall *a = &BAKED_WALLS[i];
+    const Wall *b = &walls[i];
+    if (a->minx != b->minx || a->minz != b->minz || a->maxx != b->maxx ||
+        a->maxz != b->maxz || a->height != b->height ||
+        a->color != b->color || a->visible_faces != b->visible_faces ||
+        memcmp(a->ao, b->ao, sizeof(a->ao)) != 0) {
+      fprintf(stderr, "wall %d differs\n", i);
+      errors++;
+    }
+  }
+  for (r = 0; r < MAZE_H; r++) {
+    for (c = 0; c < MAZE_W; c++) {
+      if (BAKED_WALL_GRID[r][c] != grid[r][c]) {
+        fprintf(stderr, "grid cell (%d, %d): baked %d, runtime %d\n", r, c,
+                BAKED_WALL_GRID[r][c], grid[r][c]);
+        errors++;
+      }
+    }
+  }
+  if (errors)
+    fprintf(stderr, "maze_baked.h is stale; run `make maze_baked.h`\n");
+  else
+    printf("maze_baked.h matches the runtime builder (%d walls)\n", count);
+  return errors != 0;
+}
+#endif
+
+int main(int argc, char **argv) {
+  static Wall walls[MAX_WALLS];
+  static short grid[MAZE_H][MAZE_W];
+  int count = buildWalls(walls, MAX_WALLS, grid);
+
+  if (argc > 1 && strcmp(argv[1], "--check") == 0) {
+#ifdef MAZE_BAKED
+    return checkBaked(walls, count, grid);
+#else
+    fprintf(stderr, "--check needs a build with -DMAZE_BAKED\n");
+    return 2;
+#endif
+  }
+  emitHeader(walls, count, grid);
+  return 0;
+}
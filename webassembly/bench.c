@@ -0,0 +1,299 @@
+// Kernel microbenchmarks for the rasterizer hot paths in graphics.c. Every
+// case runs one function on a fixed synthetic workload and prints one TSV row:
+//
+//   case  pixels/op  ns/op  Mpixels/s
+//
+// ns/op is the best of BENCH_TRIALS trials; pixels are counted once per case
+// by drawing a single op into a cleared buffer (Mpixels/s is "-" for kernels
+// that write none). Rows are stable across runs, so two result files diff
+// cleanly. Builds natively (`make bench`) and as a libc-free WASI
+// command (`make bench-wasm`, run under wasmtime or another WASI runtime).
+#include "graphics.c"
+
+#define BENCH_BATCH 64
+#define BENCH_TRIALS 5
+#define BENCH_MIN_TRIAL_NS 20000000ull
+
+// --------- Platform ---------
+#ifdef __wasm__
+// Just the two WASI calls the suite needs, so the module links without libc.
+typedef struct {
+  const void *buf;
+  unsigned int len;
+} WasiIovec;
+
+__attribute__((import_module("wasi_snapshot_preview1"),
+               import_name("clock_time_get"))) int
+wasi_clock_time_get(int clockId, unsigned long long precision,
+                    unsigned long long *time);
+__attribute__((import_module("wasi_snapshot_preview1"),
+               import_name("fd_write"))) int
+wasi_fd_write(int fd, const WasiIovec *iovs, int count, unsigned int *written);
+
+static unsigned long long nowNs() {
+  unsigned long long t = 0;
+  wasi_clock_time_get(1, 1, &t); // 1 = monotonic
+  return t;
+}
+
+static void writeOut(const char *text, int len) {
+  WasiIovec iov = {text, (unsigned int)len};
+  unsigned int written;
+  wasi_fd_write(1, &iov, 1, &written);
+}
+#else
+#include <time.h>
+#include <unistd.h>
+
+static unsigned long long nowNs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ull +
+         (unsigned long long)ts.tv_nsec;
+}
+
+static void writeOut(const char *text, int len) {
+  if (write(1, text, (unsigned long)len) < 0)
+    return;
+}
+#endif
+
+// --------- Output ---------
+static char OUT[4096];
+static int out_len = 0;
+
+static void putStr(const char *s) {
+  while (*s && out_len < (int)sizeof(OUT))
+    OUT[out_len++] = *s++;
+}
+
+static void putUint(unsigned long long v) {
+  char digits[24];
+  int n = 0;
+  do {
+    digits[n++] = (char)('0' + v % 10u);
+    v /= 10u;
+  } while (v);
+  while (n > 0 && out_len < (int)sizeof(OUT))
+    OUT[out_len++] = digits[--n];
+}
+
+// Fixed-point with `decimals` places, rounded half up.
+static void putFixed(double v, int decimals) {
+  unsigned long long scale = 1;
+  int i;
+  for (i = 0; i < decimals; i++)
+    scale *= 10u;
+  unsigned long long q = (unsigned long long)(v * (double)scale + 0.5);
+  putUint(q / scale);
+  if (decimals > 0) {
+    putStr(".");
+    unsigned long long frac = q % scale;
+    for (scale /= 10u; scale > 0; scale /= 10u) {
+      putUint(frac / scale);
+      frac %= scale;
+    }
+  }
+}
+
+static void flushOut() {
+  writeOut(OUT, out_len);
+  out_len = 0;
+}
+
+// --------- Workloads ---------
+// Results land here so the optimizer cannot drop the clip and rotate kernels.
+volatile float BENCH_SINK;
+
+// Each batch draws nearer and nearer (z 50 down to ~2.7), so every op passes
+// the depth test and writes its full coverage.
+static float opDepth(int i) { return 50.0f - 0.74f * (float)i; }
+
+static void triTiny(int i) {
+  float z = opDepth(i);
+  drawFilledTriangle(300, 300, z, 304, 300, z, 300, 304, z, 0xff3344ffu);
+}
+
+static void triThin(int i) {
+  float z = opDepth(i);
+  drawFilledTriangle(10, 300, z, 590, 302, z, 10, 303, z, 0xff3344ffu);
+}
+
+static void triHuge(int i) {
+  float z = opDepth(i);
+  drawFilledTriangle(50, 50, z, 550, 80, z + 1.0f, 300, 560, z, 0xff3344ffu);
+}
+
+// Reaches past every screen edge; x + y <= 1200 holds for all pixels.
+static void triCover(int i) {
+  float z = opDepth(i);
+  drawFilledTriangle(-10, -10, z, 1210, -10, z, -10, 1210, z, 0xff3344ffu);
+}
+
+static const Vec3 QUAD_INSIDE[4] = {
+    {-1.0f, -1.0f, 5.0f}, {1.0f, -1.0f, 5.0f},
+    {1.0f, 1.0f, 6.0f},   {-1.0f, 1.0f, 6.0f}};
+
+// Crosses both side planes but stays inside the guard band.
+static const Vec3 QUAD_SIDES[4] = {
+    {-12.0f, -1.0f, 4.0f}, {12.0f, -1.0f, 4.0f},
+    {12.0f, 1.0f, 5.0f},   {-12.0f, 1.0f, 5.0f}};
+
+// Crosses the near plane and both side planes, like a wall beside the camera.
+static const Vec3 QUAD_STRADDLE[4] = {
+    {-20.0f, -1.0f, 0.01f}, {20.0f, -1.0f, 0.01f},
+    {20.0f, 1.0f, 10.0f},   {-20.0f, 1.0f, 10.0f}};
+
+static void clipFaceInside(int i) {
+  Vec3 a[16], b[16];
+  const Vec3 *poly;
+  (void)i;
+  BENCH_SINK = (float)clipFace(QUAD_INSIDE, 4, a, b, &poly);
+}
+
+static void clipFaceSides(int i) {
+  Vec3 a[16], b[16];
+  const Vec3 *poly;
+  (void)i;
+  BENCH_SINK = (float)clipFace(QUAD_SIDES, 4, a, b, &poly);
+}
+
+static void clipFaceStraddle(int i) {
+  Vec3 a[16], b[16];
+  const Vec3 *poly;
+  (void)i;
+  BENCH_SINK = (float)clipFace(QUAD_STRADDLE, 4, a, b, &poly);
+}
+
+static void clipPlaneInside(int i) {
+  Vec3 a[16];
+  (void)i;
+  BENCH_SINK = (float)clipPlane(QUAD_INSIDE, 4, a, 0.0f, 0.0f, 1.0f,
+                                -NEAR_PLANE);
+}
+
+static void clipPlaneStraddle(int i) {
+  Vec3 a[16];
+  (void)i;
+  BENCH_SINK = (float)clipPlane(QUAD_STRADDLE, 4, a, 0.0f, 0.0f, 1.0f,
+                                -NEAR_PLANE);
+}
+
+static void lineShort(int i) {
+  float z = opDepth(i);
+  drawLineDepth(300, 300, z, 310, 306, z, 0xffffffffu);
+}
+
+static void lineLong(int i) {
+  float z = opDepth(i);
+  drawLineDepth(0, 10, z, 599, 590, z, 0xffffffffu);
+}
+
+// Entirely left of the screen: every step is bounds-checked and skipped.
+static void lineOffscreen(int i) {
+  float z = opDepth(i);
+  drawLineDepth(-500, -400, z, -100, 700, z, 0xffffffffu);
+}
+
+static void clear(int i) { clearBuffer(0xff000000u + (unsigned int)i); }
+
+static void rotate(int i) {
+  Vec3 v = {(float)i * 0.1f, 1.0f, 5.0f - (float)i * 0.05f};
+  Vec3 r = rotateYawPitch(v, 0.8f, 0.6f, 0.96f, 0.28f);
+  BENCH_SINK = r.x + r.y + r.z;
+}
+
+typedef struct {
+  const char *name;
+  void (*op)(int i);
+  int resetDepth; // clear DEPTH (untimed) before each batch
+} BenchCase;
+
+static const BenchCase CASES[] = {
+    {"tri_tiny", triTiny, 1},
+    {"tri_thin", triThin, 1},
+    {"tri_huge", triHuge, 1},
+    {"tri_cover", triCover, 1},
+    {"clip_face_inside", clipFaceInside, 0},
+    {"clip_face_sides", clipFaceSides, 0},
+    {"clip_face_straddle", clipFaceStraddle, 0},
+    {"clip_plane_inside", clipPlaneInside, 0},
+    {"clip_plane_straddle", clipPlaneStraddle, 0},
+    {"line_short", lineShort, 1},
+    {"line_long", lineLong, 1},
+    {"line_offscreen", lineOffscreen, 1},
+    {"clear_buffer", clear, 0},
+    {"rotate_yaw_pitch", rotate, 0},
+};
+
+// Pixels one op writes, measured on a cleared buffer.
+static unsigned int pixelsPerOp(const BenchCase *c) {
+  unsigned int i, count = 0;
+  clearBuffer(0);
+  c->op(0);
+  for (i = 0; i < PIXEL_COUNT; i++)
+    count += BUFFER[i] != 0;
+  return count;
+}
+
+static unsigned long long runBatch(const BenchCase *c) {
+  int i;
+  if (c->resetDepth)
+    clearBuffer(0);
+  unsigned long long start = nowNs();
+  for (i = 0; i < BENCH_BATCH; i++)
+    c->op(i);
+  return nowNs() - start;
+}
+
+static void runCase(const BenchCase *c) {
+  unsigned int pixels = pixelsPerOp(c);
+
+  // The first trial sizes the rest: enough batches to fill the minimum time.
+  unsigned long long batches = 0, elapsed = 0;
+  while (elapsed < BENCH_MIN_TRIAL_NS) {
+    elapsed += runBatch(c);
+    batches++;
+  }
+  unsigned long long best = elapsed;
+  int trial;
+  for (trial = 1; trial < BENCH_TRIALS; trial++) {
+    unsigned long long b;
+    elapsed = 0;
+    for (b = 0; b < batches; b++)
+      elapsed += runBatch(c);
+    if (elapsed < best)
+      best = elapsed;
+  }
+
+  double nsPerOp = (double)best / (double)(batches * BENCH_BATCH);
+  putStr(c->name);
+  putStr("\t");
+  putUint(pixels);
+  putStr("\t");
+  putFixed(nsPerOp, 2);
+  putStr("\t");
+  if (pixels)
+    putFixed((double)pixels * 1000.0 / nsPerOp, 1); // pixels/ns * 1e3 = Mpx/s
+  else
+    putStr("-");
+  putStr("\n");
+  flushOut();
+}
+
+static void runBenchmarks() {
+  unsigned int i;
+  putStr("case\tpixels/op\tns/op\tMpixels/s\n");
+  flushOut();
+  for (i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++)
+    runCase(&CASES[i]);
+}
+
+#ifdef __wasm__
+void _start() { runBenchmarks(); }
+#else
+int main() {
+  runBenchmarks();
+  return 0;
+}
+#endif
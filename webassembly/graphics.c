@@ -1,5 +1,6 @@
 // Minimal 3D wireframe maze "game" rendered in software for WebAssembly.
 // Movement: WASD to move, mouse to look, Space to jump, Shift to sprint.
+// F toggles the flashlight.
 #define WIDTH 600u
 #define HEIGHT 600u
 #define PIXEL_COUNT (WIDTH * HEIGHT)
@@ -7,8 +8,29 @@
 #define HALF_HEIGHT 300.0f
 #define SCREEN_GUARD                                                           \
   2 // guard band in pixels to keep faces from popping at screen edges
-unsigned int BUFFER[PIXEL_COUNT];
-float DEPTH[PIXEL_COUNT];
+// Two color and two depth buffers. The temporal mode draws each frame into
+// the pair the previous frame did not use and reads that one as history;
+// otherwise the current pair is simply reused. JS finds the frame to show
+// through frameBuffer().
+static unsigned int FRAME_BUFFERS[2][PIXEL_COUNT];
+unsigned int *BUFFER = FRAME_BUFFERS[0];
+// The depth buffer holds a key that grows towards the viewer: 1/z as a float,
+// or with DEPTH_FORMAT_16 the same 1/z quantized to 16 bits (see depthKey).
+#ifdef DEPTH_FORMAT_16
+typedef unsigned short DepthValue;
+#else
+typedef float DepthValue;
+#endif
+static DepthValue DEPTH_BUFFERS[2][PIXEL_COUNT];
+DepthValue *DEPTH = DEPTH_BUFFERS[0];
+// Rows the world pass writes: -1 = all, 0/1 = only rows with (y & 1) equal to
+// it (interlaced frames of the temporal mode).
+int RASTER_ROW_PARITY = -1;
+
+// 4-wide vectors for the span loops. These lower to simd128 when it is enabled
+// and to plain scalar code otherwise.
+typedef float f32x4 __attribute__((vector_size(16)));
+typedef int i32x4 __attribute__((vector_size(16)));
 
 typedef struct {
   float x;
@@ -22,6 +44,8 @@ typedef struct {
   unsigned int color;
   unsigned int line_color;
   unsigned char visible_faces; // bitmask of which faces/edges to render
+  float yaw; // rotation around +y in radians, 0 = axis aligned
+  const unsigned char *ao; // 6x4 vertex occlusion (FACE_VERTS order) or 0
 } Cube;
 
 typedef struct {
@@ -32,6 +56,7 @@ typedef struct {
   float height;
   unsigned int color;
   unsigned char visible_faces;
+  unsigned char ao[6][4]; // baked vertex light, 255 = unoccluded
 } Wall;
 
 // Face bits (match face order in drawCube): front, back, bottom, top, left,
@@ -114,7 +139,23 @@ const float NEAR_PLANE = 0.08f;
 const float FAR_PLANE = 60.0f;
 const float FRUSTUM_GUARD =
     1.08f; // Loosen culling to keep faces alive at screen edges.
-const float DEPTH_CLEAR = -1e30f;
+const float FRUSTUM_GUARD_NORM = 1.47183f; // sqrt(1 + FRUSTUM_GUARD^2)
+// Faces may reach this far past the frustum sides (|x|, |y| <= GUARD_BAND * z,
+// 896 px beyond each screen edge) without being clipped; setupTriangle's
+// bounding-box clamp trims them. Within the band every edge function value is
+// a half-integer under 2^23, so the float edge walk stays exact.
+const float GUARD_BAND = (HALF_WIDTH + 896.0f) / HALF_WIDTH;
+#ifdef DEPTH_FORMAT_16
+// 1/z between the far and near planes maps linearly onto 1..65535, leaving 0
+// as the clear value. The step is ~1.9e-4 in 1/z: about 0.02 units of depth at
+// z = 10 and 0.11 at the fog limit.
+const DepthValue DEPTH_CLEAR = 0;
+const float DEPTH_KEY_SCALE = 65534.0f / (1.0f / NEAR_PLANE - 1.0f / FAR_PLANE);
+const float DEPTH_KEY_BIAS =
+    1.0f - 65534.0f / (1.0f / NEAR_PLANE - 1.0f / FAR_PLANE) / FAR_PLANE;
+#else
+const DepthValue DEPTH_CLEAR = -1e30f;
+#endif
 
 // Constants and helpers (no stdlib).
 const float PI = 3.14159265f;
@@ -210,10 +251,11 @@ unsigned int lerp_color(unsigned int c0, unsigned int c1, float t) {
   unsigned int g1 = (c1 >> 8) & 0xffu;
   unsigned int b1 = (c1) & 0xffu;
 
-  unsigned int a = (unsigned int)(a0 + (a1 - a0) * t);
-  unsigned int r = (unsigned int)(r0 + (r1 - r0) * t);
-  unsigned int g = (unsigned int)(g0 + (g1 - g0) * t);
-  unsigned int b = (unsigned int)(b0 + (b1 - b0) * t);
+  // Blend in float so a darker target does not wrap the unsigned delta.
+  unsigned int a = (unsigned int)((float)a0 + ((float)a1 - (float)a0) * t);
+  unsigned int r = (unsigned int)((float)r0 + ((float)r1 - (float)r0) * t);
+  unsigned int g = (unsigned int)((float)g0 + ((float)g1 - (float)g0) * t);
+  unsigned int b = (unsigned int)((float)b0 + ((float)b1 - (float)b0) * t);
   return r | (g << 8) | (b << 16) | (a << 24);
 }
 
@@ -221,6 +263,153 @@ float fog_factor(float depth) {
   return clamp01((depth - FOG_NEAR) * FOG_INV_RANGE);
 }
 
+// Per-face color terms for the shaded rasterizer. A fragment with occlusion
+// shade s in [0, 256] gets channel lo + ((span * s) >> 8): the lit color is
+// darkened first and fog is blended in afterwards.
+typedef struct {
+  int lo[3];       // r, g, b of a fully occluded fragment (fog only)
+  int span[3];     // lit minus occluded
+  float albedo[3]; // fogged base color, scaled by dynamic light
+  Vec3 normal;     // camera space, for dynamic lights
+  unsigned int alpha;
+} FaceShade;
+
+static FaceShade makeFaceShade(unsigned int argb, float brightness,
+                               float fog) {
+  FaceShade fs;
+  brightness = clamp01(brightness);
+  fog = clamp01(fog);
+  int k;
+  for (k = 0; k < 3; k++) {
+    unsigned int shift = 16u - 8u * (unsigned int)k; // r, g, b
+    float base = (float)((argb >> shift) & 0xffu) * brightness;
+    float fogc = (float)((FOG_COLOR >> shift) & 0xffu) * fog;
+    fs.lo[k] = (int)fogc;
+    fs.span[k] = (int)(base * (1.0f - fog) + fogc) - fs.lo[k];
+    fs.albedo[k] = (float)((argb >> shift) & 0xffu) * (1.0f - fog);
+  }
+  fs.normal.x = 0.0f;
+  fs.normal.y = 0.0f;
+  fs.normal.z = 0.0f;
+  fs.alpha = (argb >> 24) & 0xffu;
+  return fs;
+}
+
+static unsigned int shadeColor(const FaceShade *fs, int shade) {
+  unsigned int r = (unsigned int)(fs->lo[0] + ((fs->span[0] * shade) >> 8));
+  unsigned int g = (unsigned int)(fs->lo[1] + ((fs->span[1] * shade) >> 8));
+  unsigned int b = (unsigned int)(fs->lo[2] + ((fs->span[2] * shade) >> 8));
+  return r | (g << 8) | (b << 16) | (fs->alpha << 24);
+}
+
+// --------- Dynamic lights ---------
+// Point lights are written by JS into LIGHTS (6 words each). Every frame they
+// are moved to camera space and binned into screen tiles, so a fragment only
+// evaluates the short list of its own tile.
+typedef struct {
+  float x; // world position
+  float y;
+  float z;
+  float radius;       // light falls off to zero at this distance
+  float intensity;    // 1 = color at full strength
+  unsigned int color; // 0xAARRGGBB
+} PointLight;
+
+#define MAX_LIGHTS 64
+PointLight LIGHTS[MAX_LIGHTS];
+int LIGHT_COUNT = 0;
+int FLASHLIGHT_ON = 0;
+
+// Flashlight: a spot light at the eye looking down the view axis.
+const float FLASHLIGHT_RANGE = 12.0f;
+const float FLASHLIGHT_COS_INNER = 0.951f; // ~18 degrees
+const float FLASHLIGHT_COS_OUTER = 0.883f; // ~28 degrees
+const float FLASHLIGHT_TAN_OUTER = 0.532f;
+const unsigned int FLASHLIGHT_COLOR = 0xfffff3d6;
+
+#define LIGHT_TILE_SHIFT 5u
+#define LIGHT_TILE_SIZE (1u << LIGHT_TILE_SHIFT)
+#define LIGHT_TILES_X ((WIDTH + LIGHT_TILE_SIZE - 1u) / LIGHT_TILE_SIZE)
+#define LIGHT_TILES_Y ((HEIGHT + LIGHT_TILE_SIZE - 1u) / LIGHT_TILE_SIZE)
+// Quality limit: a full tile keeps the lights with the largest estimated
+// contribution and drops the rest. It also bounds the per-pixel loop, which
+// is why cost stays flat with more overlapping lights.
+#define MAX_TILE_LIGHTS 16u
+
+typedef struct {
+  Vec3 pos; // camera space
+  float radius2;
+  float invRadius2;
+  float r, g, b; // color * intensity, 0..1 per channel
+  int spot;      // flashlight cone around +z
+} ViewLight;
+
+static ViewLight VIEW_LIGHTS[MAX_LIGHTS + 1];
+static int view_light_count = 0;
+static unsigned char TILE_LIGHT_COUNT[LIGHT_TILES_X * LIGHT_TILES_Y];
+static unsigned char TILE_LIGHTS[LIGHT_TILES_X * LIGHT_TILES_Y]
+                                [MAX_TILE_LIGHTS];
+static float TILE_LIGHT_WEIGHT[LIGHT_TILES_X * LIGHT_TILES_Y]
+                              [MAX_TILE_LIGHTS];
+
+void setLights(int count, int flashlight) {
+  if (count < 0)
+    count = 0;
+  if (count > MAX_LIGHTS)
+    count = MAX_LIGHTS;
+  LIGHT_COUNT = count;
+  FLASHLIGHT_ON = flashlight != 0;
+}
+
+// Shade a fragment at pixel (x, y) against its tile's light list. Lights use
+// a squared (1 - d^2/r^2) falloff and a Lambert term against the face normal.
+static unsigned int litColor(const FaceShade *fs, int shade,
+                             const unsigned char *list, unsigned int count,
+                             int x, int y, float invZ) {
+  float z = 1.0f / invZ;
+  Vec3 p;
+  p.x = ((float)x + 0.5f - HALF_WIDTH) * (z / HALF_WIDTH);
+  p.y = (HALF_HEIGHT - (float)y - 0.5f) * (z / HALF_HEIGHT);
+  p.z = z;
+  float acc[3] = {0.0f, 0.0f, 0.0f};
+  unsigned int i;
+  for (i = 0; i < count; i++) {
+    const ViewLight *l = &VIEW_LIGHTS[list[i]];
+    float dx = l->pos.x - p.x;
+    float dy = l->pos.y - p.y;
+    float dz = l->pos.z - p.z;
+    float d2 = dx * dx + dy * dy + dz * dz;
+    if (d2 >= l->radius2)
+      continue;
+    float ndl = dx * fs->normal.x + dy * fs->normal.y + dz * fs->normal.z;
+    if (ndl <= 0.0f)
+      continue;
+    float invLen = 1.0f / __builtin_sqrtf(d2 + 1e-6f);
+    float att = 1.0f - d2 * l->invRadius2;
+    float k = att * att * ndl * invLen;
+    if (l->spot) {
+      // Light sits at the eye, so the cone angle is the angle of -d to +z.
+      float cone = (-dz * invLen - FLASHLIGHT_COS_OUTER) /
+                   (FLASHLIGHT_COS_INNER - FLASHLIGHT_COS_OUTER);
+      k *= clamp01(cone);
+    }
+    acc[0] += k * l->r;
+    acc[1] += k * l->g;
+    acc[2] += k * l->b;
+  }
+
+  unsigned int out = fs->alpha << 24;
+  int c;
+  for (c = 0; c < 3; c++) {
+    int v = fs->lo[c] + ((fs->span[c] * shade) >> 8) +
+            (int)(fs->albedo[c] * acc[c]);
+    if (v > 255)
+      v = 255;
+    out |= (unsigned int)v << (8u * (unsigned int)c);
+  }
+  return out;
+}
+
 float face_brightness(Vec3 normal) {
   float dot =
       normal.x * LIGHT_DIR.x + normal.y * LIGHT_DIR.y + normal.z * LIGHT_DIR.z;
@@ -239,20 +428,145 @@ void setInput(int keyMask, int mouseDx, int mouseDy) {
 void clearBuffer(unsigned int color) {
   unsigned int i;
   unsigned int fill = argb_to_rgba(color);
-  for (i = 0; i < PIXEL_COUNT; i++) {
+  if (RASTER_ROW_PARITY >= 0) {
+    unsigned int y;
+    for (y = (unsigned int)RASTER_ROW_PARITY; y < HEIGHT; y += 2) {
+      for (i = y * WIDTH; i < (y + 1) * WIDTH; i++) {
+        BUFFER[i] = fill;
+        DEPTH[i] = DEPTH_CLEAR;
+      }
+    }
+    return;
+  }
+  for (i = 0; i < PIXEL_COUNT; i++)
     BUFFER[i] = fill;
+  // Separate pass: the 16-bit clear is a zero fill (memory.fill).
+  for (i = 0; i < PIXEL_COUNT; i++)
     DEPTH[i] = DEPTH_CLEAR;
-  }
 }
 
+unsigned int *frameBuffer() { return BUFFER; }
+
+// Overlay pixel. It takes no depth, so the temporal mode never reprojects
+// HUD pixels out of the history.
 void plot(int x, int y, unsigned int color) {
   if ((unsigned int)x >= WIDTH || (unsigned int)y >= HEIGHT)
     return;
-  BUFFER[(unsigned int)y * WIDTH + (unsigned int)x] = color;
+  unsigned int idx = (unsigned int)y * WIDTH + (unsigned int)x;
+  BUFFER[idx] = color;
+  DEPTH[idx] = DEPTH_CLEAR;
 }
 
-void drawFilledTriangle(int x0, int y0, float z0, int x1, int y1, float z1,
-                        int x2, int y2, float z2, unsigned int color) {
+// Depth keys are affine in 1/z, so rasterizers interpolate them directly.
+#ifdef DEPTH_FORMAT_16
+static float depthKey(float invZ) {
+  return invZ * DEPTH_KEY_SCALE + DEPTH_KEY_BIAS;
+}
+
+static float keyToInvZ(float key) {
+  return (key - DEPTH_KEY_BIAS) * (1.0f / DEPTH_KEY_SCALE);
+}
+
+// Nearer-wins test and write for one pixel. Keys below 1 lie beyond the far
+// plane or behind the eye.
+static int depthTestSet(unsigned int idx, float key) {
+  if (!(key >= 1.0f))
+    return 0;
+  unsigned int q = key < 65535.0f ? (unsigned int)key : 65535u;
+  if (q <= DEPTH[idx])
+    return 0;
+  DEPTH[idx] = (DepthValue)q;
+  return 1;
+}
+
+// Same test for four neighboring pixels; returns the lanes that passed.
+static i32x4 depthTestSet4(unsigned int idx, f32x4 key, i32x4 live) {
+  typedef unsigned short u16x4 __attribute__((vector_size(8)));
+  u16x4 stored;
+  __builtin_memcpy(&stored, &DEPTH[idx], sizeof(stored));
+  i32x4 cur = __builtin_convertvector(stored, i32x4);
+  i32x4 big = key > 65535.0f;
+  i32x4 q = (__builtin_convertvector(key, i32x4) & ~big) | (big & 65535);
+  i32x4 pass = live & (key >= 1.0f) & (q > cur);
+  u16x4 out = __builtin_convertvector((q & pass) | (cur & ~pass), u16x4);
+  __builtin_memcpy(&DEPTH[idx], &out, sizeof(out));
+  return pass;
+}
+
+static f32x4 loadDepth4(const DepthValue *depth) {
+  typedef unsigned short u16x4 __attribute__((vector_size(8)));
+  u16x4 stored;
+  __builtin_memcpy(&stored, depth, sizeof(stored));
+  return __builtin_convertvector(stored, f32x4);
+}
+
+static f32x4 keyToInvZ4(f32x4 key) {
+  return (key - DEPTH_KEY_BIAS) * (1.0f / DEPTH_KEY_SCALE);
+}
+#else
+static float depthKey(float invZ) { return invZ; }
+
+static float keyToInvZ(float key) { return key; }
+
+// Compare inverse depth so nearer fragments (larger 1/z) win.
+static int depthTestSet(unsigned int idx, float key) {
+  if (!(key > 0.0f) || key <= DEPTH[idx])
+    return 0;
+  DEPTH[idx] = key;
+  return 1;
+}
+
+// Same test for four neighboring pixels; returns the lanes that passed.
+static i32x4 depthTestSet4(unsigned int idx, f32x4 key, i32x4 live) {
+  f32x4 cur;
+  __builtin_memcpy(&cur, &DEPTH[idx], sizeof(cur));
+  i32x4 pass = live & (key > 0.0f) & (key > cur);
+  i32x4 out = ((i32x4)key & pass) | ((i32x4)cur & ~pass);
+  __builtin_memcpy(&DEPTH[idx], &out, sizeof(out));
+  return pass;
+}
+
+static f32x4 loadDepth4(const DepthValue *depth) {
+  f32x4 stored;
+  __builtin_memcpy(&stored, depth, sizeof(stored));
+  return stored;
+}
+
+static f32x4 keyToInvZ4(f32x4 key) { return key; }
+#endif
+
+static const f32x4 LANE_X = {0.0f, 1.0f, 2.0f, 3.0f};
+
+static int anyLane(i32x4 m) { return (m[0] | m[1] | m[2] | m[3]) != 0; }
+
+static void storeColor4(unsigned int idx, i32x4 color, i32x4 pass) {
+  i32x4 cur;
+  __builtin_memcpy(&cur, &BUFFER[idx], sizeof(cur));
+  cur = (color & pass) | (cur & ~pass);
+  __builtin_memcpy(&BUFFER[idx], &cur, sizeof(cur));
+}
+
+static i32x4 shadeColor4(const FaceShade *fs, i32x4 shade) {
+  i32x4 r = fs->lo[0] + ((fs->span[0] * shade) >> 8);
+  i32x4 g = fs->lo[1] + ((fs->span[1] * shade) >> 8);
+  i32x4 b = fs->lo[2] + ((fs->span[2] * shade) >> 8);
+  return r | (g << 8) | (b << 16) | (int)(fs->alpha << 24);
+}
+
+// Shared triangle setup: screen bounds clamped to the buffer, edge functions
+// evaluated at the first pixel center and their per-pixel/per-row steps.
+typedef struct {
+  int minx, miny, maxx, maxy;
+  float area, invArea;
+  float stepW0x, stepW0y, stepW1x, stepW1y, stepW2x, stepW2y;
+  float w0_row, w1_row, w2_row;
+  float key_row, stepKx, stepKy; // depth key at the first pixel and steps
+  int rowStep;                   // 2 on interlaced frames
+} TriSetup;
+
+// Returns 0 when the triangle is degenerate or entirely off-screen.
+static int setupTriangle(TriSetup *t, int x0, int y0, float z0, int x1,
+                         int y1, float z1, int x2, int y2, float z2) {
   int minx = x0;
   if (x1 < minx)
     minx = x1;
@@ -275,7 +589,7 @@ void drawFilledTriangle(int x0, int y0, float z0, int x1, int y1, float z1,
     maxy = y2;
 
   if (maxx < 0 || maxy < 0 || minx >= (int)WIDTH || miny >= (int)HEIGHT)
-    return;
+    return 0;
   if (minx < 0)
     minx = 0;
   if (miny < 0)
@@ -290,62 +604,216 @@ void drawFilledTriangle(int x0, int y0, float z0, int x1, int y1, float z1,
   // positive.
   float area = (float)((x0 - x1) * (y2 - y1) - (y0 - y1) * (x2 - x1));
   if (area > -1e-6f && area < 1e-6f)
-    return;
-
-  float invArea = 1.0f / area;
+    return 0;
 
-  // Perspective-correct depth: interpolate 1/z linearly in screen space.
-  float invZ0 = 1.0f / z0;
-  float invZ1 = 1.0f / z1;
-  float invZ2 = 1.0f / z2;
+  t->minx = minx;
+  t->miny = miny;
+  t->maxx = maxx;
+  t->maxy = maxy;
+  t->area = area;
+  t->invArea = 1.0f / area;
 
   // Edge deltas for incremental evaluation.
-  float stepW0x = (float)(y2 - y1);
-  float stepW0y = -(float)(x2 - x1);
-  float stepW1x = (float)(y0 - y2);
-  float stepW1y = -(float)(x0 - x2);
-  float stepW2x = (float)(y1 - y0);
-  float stepW2y = -(float)(x1 - x0);
+  t->stepW0x = (float)(y2 - y1);
+  t->stepW0y = -(float)(x2 - x1);
+  t->stepW1x = (float)(y0 - y2);
+  t->stepW1y = -(float)(x0 - x2);
+  t->stepW2x = (float)(y1 - y0);
+  t->stepW2y = -(float)(x1 - x0);
 
   // Sample at pixel centers (add 0.5) to keep coverage consistent.
   float startX = (float)minx + 0.5f;
   float startY = (float)miny + 0.5f;
-  float w0_row = (startX - (float)x1) * (float)(y2 - y1) -
-                 (startY - (float)y1) * (float)(x2 - x1);
-  float w1_row = (startX - (float)x2) * (float)(y0 - y2) -
-                 (startY - (float)y2) * (float)(x0 - x2);
-  float w2_row = (startX - (float)x0) * (float)(y1 - y0) -
-                 (startY - (float)y0) * (float)(x1 - x0);
+  t->w0_row = (startX - (float)x1) * (float)(y2 - y1) -
+              (startY - (float)y1) * (float)(x2 - x1);
+  t->w1_row = (startX - (float)x2) * (float)(y0 - y2) -
+              (startY - (float)y2) * (float)(x0 - x2);
+  t->w2_row = (startX - (float)x0) * (float)(y1 - y0) -
+              (startY - (float)y0) * (float)(x1 - x0);
+
+  // Perspective-correct depth: 1/z (and so the depth key) is affine in screen
+  // space.
+  float k0 = depthKey(1.0f / z0);
+  float k1 = depthKey(1.0f / z1);
+  float k2 = depthKey(1.0f / z2);
+  float invArea = t->invArea;
+  t->key_row = (t->w0_row * k0 + t->w1_row * k1 + t->w2_row * k2) * invArea;
+  t->stepKx = (t->stepW0x * k0 + t->stepW1x * k1 + t->stepW2x * k2) * invArea;
+  t->stepKy = (t->stepW0y * k0 + t->stepW1y * k1 + t->stepW2y * k2) * invArea;
+
+  // Interlaced frames: start on the first row of the right parity and step
+  // two rows at a time. Row steps of derived attributes follow automatically.
+  if (RASTER_ROW_PARITY >= 0) {
+    if ((t->miny & 1) != RASTER_ROW_PARITY) {
+      t->miny++;
+      t->w0_row += t->stepW0y;
+      t->w1_row += t->stepW1y;
+      t->w2_row += t->stepW2y;
+      t->key_row += t->stepKy;
+    }
+    if (t->miny > t->maxy)
+      return 0;
+    t->rowStep = 2;
+    t->stepW0y *= 2.0f;
+    t->stepW1y *= 2.0f;
+    t->stepW2y *= 2.0f;
+    t->stepKy *= 2.0f;
+  } else {
+    t->rowStep = 1;
+  }
+  return 1;
+}
+
+void drawFilledTriangle(int x0, int y0, float z0, int x1, int y1, float z1,
+                        int x2, int y2, float z2, unsigned int color) {
+  TriSetup t;
+  if (!setupTriangle(&t, x0, y0, z0, x1, y1, z1, x2, y2, z2))
+    return;
+  float area = t.area;
+  float w0_row = t.w0_row;
+  float w1_row = t.w1_row;
+  float w2_row = t.w2_row;
+  float key_row = t.key_row;
+  i32x4 colorv = {(int)color, (int)color, (int)color, (int)color};
 
   int y;
-  for (y = miny; y <= maxy; y++) {
+  for (y = t.miny; y <= t.maxy; y += t.rowStep) {
     float w0 = w0_row;
     float w1 = w1_row;
     float w2 = w2_row;
-    int x;
-    for (x = minx; x <= maxx; x++) {
+    float key = key_row;
+    unsigned int idx = (unsigned int)y * WIDTH + (unsigned int)t.minx;
+    int x = t.minx;
+    // Four pixels per step, then a scalar tail to finish the row.
+    for (; x + 3 <= t.maxx; x += 4, idx += 4) {
+      f32x4 w0v = w0 + LANE_X * t.stepW0x;
+      f32x4 w1v = w1 + LANE_X * t.stepW1x;
+      f32x4 w2v = w2 + LANE_X * t.stepW2x;
+      i32x4 inside =
+          (w0v * area >= 0.0f) & (w1v * area >= 0.0f) & (w2v * area >= 0.0f);
+      if (anyLane(inside)) {
+        i32x4 pass = depthTestSet4(idx, key + LANE_X * t.stepKx, inside);
+        if (anyLane(pass))
+          storeColor4(idx, colorv, pass);
+      }
+      w0 += 4.0f * t.stepW0x;
+      w1 += 4.0f * t.stepW1x;
+      w2 += 4.0f * t.stepW2x;
+      key += 4.0f * t.stepKx;
+    }
+    for (; x <= t.maxx; x++, idx++) {
       if (w0 * area >= 0.0f && w1 * area >= 0.0f && w2 * area >= 0.0f) {
-        float bw0 = w0 * invArea;
-        float bw1 = w1 * invArea;
-        float bw2 = w2 * invArea;
-        float invZ = bw0 * invZ0 + bw1 * invZ1 + bw2 * invZ2;
-        if (invZ > 0.0f) {
-          unsigned int idx = (unsigned int)y * WIDTH + (unsigned int)x;
-          float current = DEPTH[idx];
-          // Compare inverse depth so nearer fragments (larger 1/z) win.
-          if (invZ > current) {
-            DEPTH[idx] = invZ;
-            BUFFER[idx] = color;
+        if (depthTestSet(idx, key))
+          BUFFER[idx] = color;
+      }
+      w0 += t.stepW0x;
+      w1 += t.stepW1x;
+      w2 += t.stepW2x;
+      key += t.stepKx;
+    }
+    w0_row += t.stepW0y;
+    w1_row += t.stepW1y;
+    w2_row += t.stepW2y;
+    key_row += t.stepKy;
+  }
+}
+
+// Same coverage and depth test as drawFilledTriangle, plus a per-vertex
+// occlusion shade (0..256) interpolated perspective-correctly across the
+// triangle.
+void drawShadedTriangle(int x0, int y0, float z0, float s0, int x1, int y1,
+                        float z1, float s1, int x2, int y2, float z2, float s2,
+                        const FaceShade *fs) {
+  TriSetup t;
+  if (!setupTriangle(&t, x0, y0, z0, x1, y1, z1, x2, y2, z2))
+    return;
+  float area = t.area;
+  float invArea = t.invArea;
+  float w0_row = t.w0_row;
+  float w1_row = t.w1_row;
+  float w2_row = t.w2_row;
+  float key_row = t.key_row;
+  // Only 1/z and shade/z are affine in screen space: step shade/z like the
+  // depth key and divide by the interpolated 1/z at each pixel. Stepping the
+  // shade itself would warp the occlusion bands on walls close to the eye.
+  float q0 = s0 / z0;
+  float q1 = s1 / z1;
+  float q2 = s2 / z2;
+  float q_row = (w0_row * q0 + w1_row * q1 + w2_row * q2) * invArea;
+  float stepQx = (t.stepW0x * q0 + t.stepW1x * q1 + t.stepW2x * q2) * invArea;
+  float stepQy = (t.stepW0y * q0 + t.stepW1y * q1 + t.stepW2y * q2) * invArea;
+
+  int y;
+  for (y = t.miny; y <= t.maxy; y += t.rowStep) {
+    float w0 = w0_row;
+    float w1 = w1_row;
+    float w2 = w2_row;
+    float key = key_row;
+    float q = q_row;
+    unsigned int tileRow =
+        ((unsigned int)y >> LIGHT_TILE_SHIFT) * LIGHT_TILES_X;
+    unsigned int idx = (unsigned int)y * WIDTH + (unsigned int)t.minx;
+    int x = t.minx;
+    for (; x + 3 <= t.maxx; x += 4, idx += 4) {
+      f32x4 w0v = w0 + LANE_X * t.stepW0x;
+      f32x4 w1v = w1 + LANE_X * t.stepW1x;
+      f32x4 w2v = w2 + LANE_X * t.stepW2x;
+      i32x4 inside =
+          (w0v * area >= 0.0f) & (w1v * area >= 0.0f) & (w2v * area >= 0.0f);
+      if (anyLane(inside)) {
+        f32x4 keyv = key + LANE_X * t.stepKx;
+        i32x4 pass = depthTestSet4(idx, keyv, inside);
+        if (anyLane(pass)) {
+          f32x4 invZ = keyToInvZ4(keyv);
+          f32x4 shv = (q + LANE_X * stepQx) / invZ;
+          i32x4 colors = shadeColor4(fs, __builtin_convertvector(shv, i32x4));
+          // Four pixels touch at most two light tiles.
+          unsigned int tile0 = tileRow + ((unsigned int)x >> LIGHT_TILE_SHIFT);
+          unsigned int tile3 =
+              tileRow + ((unsigned int)(x + 3) >> LIGHT_TILE_SHIFT);
+          if (TILE_LIGHT_COUNT[tile0] | TILE_LIGHT_COUNT[tile3]) {
+            int l;
+            for (l = 0; l < 4; l++) {
+              unsigned int tile =
+                  tileRow + ((unsigned int)(x + l) >> LIGHT_TILE_SHIFT);
+              unsigned int lights = TILE_LIGHT_COUNT[tile];
+              if (pass[l] && lights)
+                colors[l] = (int)litColor(fs, (int)shv[l], TILE_LIGHTS[tile],
+                                          lights, x + l, y, invZ[l]);
+            }
           }
+          storeColor4(idx, colors, pass);
+        }
+      }
+      w0 += 4.0f * t.stepW0x;
+      w1 += 4.0f * t.stepW1x;
+      w2 += 4.0f * t.stepW2x;
+      key += 4.0f * t.stepKx;
+      q += 4.0f * stepQx;
+    }
+    for (; x <= t.maxx; x++, idx++) {
+      if (w0 * area >= 0.0f && w1 * area >= 0.0f && w2 * area >= 0.0f) {
+        if (depthTestSet(idx, key)) {
+          float invZ = keyToInvZ(key);
+          int sh = (int)(q / invZ);
+          unsigned int tile = tileRow + ((unsigned int)x >> LIGHT_TILE_SHIFT);
+          unsigned int lights = TILE_LIGHT_COUNT[tile];
+          BUFFER[idx] = lights ? litColor(fs, sh, TILE_LIGHTS[tile], lights,
+                                          x, y, invZ)
+                               : shadeColor(fs, sh);
         }
       }
-      w0 += stepW0x;
-      w1 += stepW1x;
-      w2 += stepW2x;
+      w0 += t.stepW0x;
+      w1 += t.stepW1x;
+      w2 += t.stepW2x;
+      key += t.stepKx;
+      q += stepQx;
     }
-    w0_row += stepW0y;
-    w1_row += stepW1y;
-    w2_row += stepW2y;
+    w0_row += t.stepW0y;
+    w1_row += t.stepW1y;
+    w2_row += t.stepW2y;
+    key_row += t.stepKy;
+    q_row += stepQy;
   }
 }
 
@@ -399,21 +867,15 @@ void drawLineDepth(int x0, int y0, float z0, int x1, int y1, float z1,
   int steps = ax > ay ? ax + 1 : ay + 1;
   if (steps < 1)
     steps = 1;
-  float invZ0 = 1.0f / z0;
-  float invZ1 = 1.0f / z1;
-  float dinvZ = (invZ1 - invZ0) / (float)steps;
-  float invZ = invZ0;
+  float key = depthKey(1.0f / z0);
+  float dkey = (depthKey(1.0f / z1) - key) / (float)steps;
 
   while (1) {
-    if ((unsigned int)x0 < WIDTH && (unsigned int)y0 < HEIGHT) {
+    if ((unsigned int)x0 < WIDTH && (unsigned int)y0 < HEIGHT &&
+        (RASTER_ROW_PARITY < 0 || (y0 & 1) == RASTER_ROW_PARITY)) {
       unsigned int idx = (unsigned int)y0 * WIDTH + (unsigned int)x0;
-      if (invZ > 0.0f) {
-        float current = DEPTH[idx];
-        if (invZ > current) {
-          DEPTH[idx] = invZ;
-          BUFFER[idx] = color;
-        }
-      }
+      if (depthTestSet(idx, key))
+        BUFFER[idx] = color;
     }
     if (x0 == x1 && y0 == y1)
       break;
@@ -426,7 +888,7 @@ void drawLineDepth(int x0, int y0, float z0, int x1, int y1, float z1,
       err += ax;
       y0 += sy;
     }
-    invZ += dinvZ;
+    key += dkey;
   }
 }
 
@@ -490,6 +952,147 @@ void project_no_clip(Vec3 p, int *sx, int *sy) {
   *sy = (int)yf;
 }
 
+// Rough peak contribution of a point light to a tile: falloff at the point of
+// the tile's view rays nearest the light (at the light's depth), times its
+// brightest channel. Ignores the Lambert term, which needs a surface.
+static float tileLightWeight(const ViewLight *l, unsigned int tx,
+                             unsigned int ty) {
+  float z = l->pos.z > NEAR_PLANE ? l->pos.z : NEAR_PLANE;
+  float scaleX = z / HALF_WIDTH;
+  float scaleY = z / HALF_HEIGHT;
+  float x0 = ((float)(tx * LIGHT_TILE_SIZE) - HALF_WIDTH) * scaleX;
+  float x1 = x0 + (float)LIGHT_TILE_SIZE * scaleX;
+  float y1 = (HALF_HEIGHT - (float)(ty * LIGHT_TILE_SIZE)) * scaleY;
+  float y0 = y1 - (float)LIGHT_TILE_SIZE * scaleY;
+  float nx = l->pos.x < x0 ? x0 : l->pos.x > x1 ? x1 : l->pos.x;
+  float ny = l->pos.y < y0 ? y0 : l->pos.y > y1 ? y1 : l->pos.y;
+  float dx = l->pos.x - nx;
+  float dy = l->pos.y - ny;
+  float dz = l->pos.z - z;
+  float att = 1.0f - (dx * dx + dy * dy + dz * dz) * l->invRadius2;
+  if (att <= 0.0f)
+    return 0.0f;
+  float peak = l->r > l->g ? l->r : l->g;
+  if (l->b > peak)
+    peak = l->b;
+  return att * att * peak;
+}
+
+// Adds VIEW_LIGHTS[index] to every tile its screen rect touches. A full tile
+// replaces its weakest light if this one is stronger there; the flashlight
+// is binned first and always kept.
+static void binLight(int index, float sx0, float sy0, float sx1, float sy1) {
+  if (sx1 < 0.0f || sy1 < 0.0f || sx0 >= (float)WIDTH ||
+      sy0 >= (float)HEIGHT)
+    return;
+  const ViewLight *l = &VIEW_LIGHTS[index];
+  unsigned int tx0 = sx0 > 0.0f ? (unsigned int)sx0 >> LIGHT_TILE_SHIFT : 0u;
+  unsigned int ty0 = sy0 > 0.0f ? (unsigned int)sy0 >> LIGHT_TILE_SHIFT : 0u;
+  unsigned int tx1 = sx1 < (float)WIDTH ? (unsigned int)sx1 >> LIGHT_TILE_SHIFT
+                                        : LIGHT_TILES_X - 1u;
+  unsigned int ty1 = sy1 < (float)HEIGHT
+                         ? (unsigned int)sy1 >> LIGHT_TILE_SHIFT
+                         : LIGHT_TILES_Y - 1u;
+  unsigned int tx, ty;
+  for (ty = ty0; ty <= ty1; ty++) {
+    for (tx = tx0; tx <= tx1; tx++) {
+      unsigned int tile = ty * LIGHT_TILES_X + tx;
+      unsigned int n = TILE_LIGHT_COUNT[tile];
+      float weight = l->spot ? 3.0e38f : tileLightWeight(l, tx, ty);
+      if (n < MAX_TILE_LIGHTS) {
+        TILE_LIGHTS[tile][n] = (unsigned char)index;
+        TILE_LIGHT_WEIGHT[tile][n] = weight;
+        TILE_LIGHT_COUNT[tile] = (unsigned char)(n + 1u);
+        continue;
+      }
+      unsigned int weakest = 0, k;
+      for (k = 1; k < MAX_TILE_LIGHTS; k++) {
+        if (TILE_LIGHT_WEIGHT[tile][k] < TILE_LIGHT_WEIGHT[tile][weakest])
+          weakest = k;
+      }
+      if (weight > TILE_LIGHT_WEIGHT[tile][weakest]) {
+        TILE_LIGHTS[tile][weakest] = (unsigned char)index;
+        TILE_LIGHT_WEIGHT[tile][weakest] = weight;
+      }
+    }
+  }
+}
+
+static void setViewLightColor(ViewLight *l, unsigned int argb,
+                              float intensity) {
+  float scale = intensity * (1.0f / 255.0f);
+  l->r = (float)((argb >> 16) & 0xffu) * scale;
+  l->g = (float)((argb >> 8) & 0xffu) * scale;
+  l->b = (float)(argb & 0xffu) * scale;
+}
+
+// Move lights to camera space and bin their screen bounds into tiles. Run once
+// per frame after updateCamera().
+void cullLights() {
+  unsigned int i;
+  for (i = 0; i < LIGHT_TILES_X * LIGHT_TILES_Y; i++)
+    TILE_LIGHT_COUNT[i] = 0;
+  view_light_count = 0;
+
+  if (FLASHLIGHT_ON) {
+    ViewLight *l = &VIEW_LIGHTS[view_light_count];
+    l->pos.x = 0.0f;
+    l->pos.y = 0.0f;
+    l->pos.z = 0.0f;
+    l->radius2 = FLASHLIGHT_RANGE * FLASHLIGHT_RANGE;
+    l->invRadius2 = 1.0f / l->radius2;
+    l->spot = 1;
+    setViewLightColor(l, FLASHLIGHT_COLOR, 1.2f);
+    float ext = FLASHLIGHT_TAN_OUTER * HALF_WIDTH * FRUSTUM_GUARD;
+    binLight(view_light_count, HALF_WIDTH - ext, HALF_HEIGHT - ext,
+             HALF_WIDTH + ext, HALF_HEIGHT + ext);
+    view_light_count++;
+  }
+
+  float cy = VIEW.cy;
+  float sy = -VIEW.sy;
+  float cp = VIEW.cp;
+  float sp = -VIEW.sp;
+  int k;
+  for (k = 0; k < LIGHT_COUNT; k++) {
+    const PointLight *pl = &LIGHTS[k];
+    float r = pl->radius;
+    if (!(r > 0.0f))
+      continue;
+    Vec3 rel;
+    rel.x = pl->x - camera_pos.x;
+    rel.y = pl->y - camera_pos.y;
+    rel.z = pl->z - camera_pos.z;
+    Vec3 c = rotateYawPitch(rel, cy, sy, cp, sp);
+    if (c.z + r < NEAR_PLANE || c.z - r > FAR_PLANE)
+      continue;
+
+    // Conservative screen rect of the sphere: extreme x/z and y/z over the
+    // box around it. A sphere reaching the near plane covers everything.
+    float sx0 = 0.0f, sy0 = 0.0f;
+    float sx1 = (float)WIDTH, sy1 = (float)HEIGHT;
+    float zn = c.z - r;
+    if (zn > NEAR_PLANE) {
+      float zf = c.z + r;
+      float lox = c.x - r, hix = c.x + r;
+      float loy = c.y - r, hiy = c.y + r;
+      sx0 = (lox / (lox < 0.0f ? zn : zf)) * HALF_WIDTH + HALF_WIDTH;
+      sx1 = (hix / (hix > 0.0f ? zn : zf)) * HALF_WIDTH + HALF_WIDTH;
+      sy0 = -(hiy / (hiy > 0.0f ? zn : zf)) * HALF_HEIGHT + HALF_HEIGHT;
+      sy1 = -(loy / (loy < 0.0f ? zn : zf)) * HALF_HEIGHT + HALF_HEIGHT;
+    }
+
+    ViewLight *l = &VIEW_LIGHTS[view_light_count];
+    l->pos = c;
+    l->radius2 = r * r;
+    l->invRadius2 = 1.0f / l->radius2;
+    l->spot = 0;
+    setViewLightColor(l, pl->color, pl->intensity);
+    binLight(view_light_count, sx0, sy0, sx1, sy1);
+    view_light_count++;
+  }
+}
+
 // Generic Sutherland–Hodgman clip against a plane n·p + d >= 0. Returns new
 // vertex count.
 static int clipPlane(const Vec3 *inPts, int inCount, Vec3 *outPts, float nx,
@@ -497,62 +1100,103 @@ static int clipPlane(const Vec3 *inPts, int inCount, Vec3 *outPts, float nx,
   if (inCount < 2)
     return 0;
   int outCount = 0;
+  // Walk edges (previous, current), carrying the previous vertex's distance.
+  Vec3 a = inPts[inCount - 1];
+  float da = a.x * nx + a.y * ny + a.z * nz + d;
   int i;
   for (i = 0; i < inCount; i++) {
-    Vec3 a = inPts[i];
-    Vec3 b = inPts[(i + 1) % inCount];
-    float da = a.x * nx + a.y * ny + a.z * nz + d;
+    Vec3 b = inPts[i];
     float db = b.x * nx + b.y * ny + b.z * nz + d;
     int aInside = da >= 0.0f;
     int bInside = db >= 0.0f;
 
-    if (aInside && bInside) {
-      outPts[outCount++] = b;
-    } else if (aInside && !bInside) {
+    if (aInside != bInside) {
       float t = da / (da - db);
       Vec3 p;
       p.x = a.x + (b.x - a.x) * t;
       p.y = a.y + (b.y - a.y) * t;
       p.z = a.z + (b.z - a.z) * t;
       outPts[outCount++] = p;
-    } else if (!aInside && bInside) {
-      float t = da / (da - db);
-      Vec3 p;
-      p.x = a.x + (b.x - a.x) * t;
-      p.y = a.y + (b.y - a.y) * t;
-      p.z = a.z + (b.z - a.z) * t;
-      outPts[outCount++] = p;
-      outPts[outCount++] = b;
     }
+    if (bInside)
+      outPts[outCount++] = b;
+    a = b;
+    da = db;
   }
   return outCount;
 }
 
-// Clip a convex polygon against the full view frustum in camera space.
-static int clipFrustum(const Vec3 *inPts, int inCount, Vec3 *tmpPtsA,
-                       Vec3 *tmpPtsB) {
-  // Order: near, far, left, right, top, bottom.
-  int count = clipPlane(inPts, inCount, tmpPtsA, 0.0f, 0.0f, 1.0f, -NEAR_PLANE);
-  if (count < 3)
-    return 0;
-  count = clipPlane(tmpPtsA, count, tmpPtsB, 0.0f, 0.0f, -1.0f, FAR_PLANE);
-  if (count < 3)
-    return 0;
-  count = clipPlane(tmpPtsB, count, tmpPtsA, 1.0f, 0.0f, FRUSTUM_GUARD,
-                    0.0f); // left: x + guard*z >= 0
-  if (count < 3)
-    return 0;
-  count = clipPlane(tmpPtsA, count, tmpPtsB, -1.0f, 0.0f, FRUSTUM_GUARD,
-                    0.0f); // right: -x + guard*z >= 0
+// Outcodes for guard-band clipping. The side bits use the visible frustum
+// (FRUSTUM_GUARD) and only serve trivial rejection; OUT_BAND marks a vertex
+// that would project outside the guard band.
+#define OUT_NEAR (1u << 0)
+#define OUT_FAR (1u << 1)
+#define OUT_LEFT (1u << 2)
+#define OUT_RIGHT (1u << 3)
+#define OUT_TOP (1u << 4)
+#define OUT_BOTTOM (1u << 5)
+#define OUT_BAND (1u << 6)
+
+static unsigned int outcode(Vec3 p) {
+  unsigned int code = 0;
+  if (p.z < NEAR_PLANE)
+    code |= OUT_NEAR;
+  if (p.z > FAR_PLANE)
+    code |= OUT_FAR;
+  float side = FRUSTUM_GUARD * p.z;
+  if (p.x < -side)
+    code |= OUT_LEFT;
+  if (p.x > side)
+    code |= OUT_RIGHT;
+  if (p.y > side)
+    code |= OUT_TOP;
+  if (p.y < -side)
+    code |= OUT_BOTTOM;
+  float band = GUARD_BAND * p.z;
+  if (p.x < -band || p.x > band || p.y < -band || p.y > band)
+    code |= OUT_BAND;
+  return code;
+}
+
+// Prepare a convex camera-space polygon for rasterization. Faces that stay
+// between the near and far planes and inside the guard band are used as they
+// are (*poly = inPts); crossing a side plane is left to the rasterizer's
+// screen clamp. Otherwise the face is clipped against near and far, and
+// against the guard-band sides only if it still leaves the band (faces right
+// next to the camera). Returns the vertex count, 0 when nothing is visible.
+static int clipFace(const Vec3 *inPts, int inCount, Vec3 *tmpPts,
+                    Vec3 *outPts, const Vec3 **poly) {
+  unsigned int any = 0;
+  unsigned int all = ~0u;
+  int j;
+  for (j = 0; j < inCount; j++) {
+    unsigned int code = outcode(inPts[j]);
+    any |= code;
+    all &= code;
+  }
+  if (all & ~OUT_BAND)
+    return 0; // every vertex outside the same frustum plane
+  *poly = inPts;
+  if (!(any & (OUT_NEAR | OUT_FAR | OUT_BAND)))
+    return inCount;
+
+  *poly = outPts;
+  int count = clipPlane(inPts, inCount, tmpPts, 0.0f, 0.0f, 1.0f, -NEAR_PLANE);
   if (count < 3)
     return 0;
-  count = clipPlane(tmpPtsB, count, tmpPtsA, 0.0f, -1.0f, FRUSTUM_GUARD,
-                    0.0f); // top: -y + guard*z >= 0
+  count = clipPlane(tmpPts, count, outPts, 0.0f, 0.0f, -1.0f, FAR_PLANE);
   if (count < 3)
     return 0;
-  count = clipPlane(tmpPtsA, count, tmpPtsB, 0.0f, 1.0f, FRUSTUM_GUARD,
-                    0.0f); // bottom: y + guard*z >= 0
-  return count;
+  any = 0;
+  for (j = 0; j < count; j++)
+    any |= outcode(outPts[j]);
+  if (!(any & OUT_BAND))
+    return count;
+  count = clipPlane(outPts, count, tmpPts, 1.0f, 0.0f, GUARD_BAND, 0.0f);
+  count = clipPlane(tmpPts, count, outPts, -1.0f, 0.0f, GUARD_BAND, 0.0f);
+  count = clipPlane(outPts, count, tmpPts, 0.0f, -1.0f, GUARD_BAND, 0.0f);
+  count = clipPlane(tmpPts, count, outPts, 0.0f, 1.0f, GUARD_BAND, 0.0f);
+  return count >= 3 ? count : 0;
 }
 
 // Quick reject: if every vertex is outside the same plane, the cube cannot hit
@@ -624,6 +1268,32 @@ static int cubeInFrustum(const Vec3 *camVerts) {
   return 1;
 }
 
+// Baked occlusion: find each clipped vertex in the face's (u, v) frame (edges
+// 0->1 and 0->3 of the rectangle) and blend the four corner values.
+static void shadeFace(const unsigned char *ao, const Vec3 *faceCam,
+                      const Vec3 *clipped, int count, float *shades) {
+  Vec3 e1, e3;
+  e1.x = faceCam[1].x - faceCam[0].x;
+  e1.y = faceCam[1].y - faceCam[0].y;
+  e1.z = faceCam[1].z - faceCam[0].z;
+  e3.x = faceCam[3].x - faceCam[0].x;
+  e3.y = faceCam[3].y - faceCam[0].y;
+  e3.z = faceCam[3].z - faceCam[0].z;
+  float inv1 = 1.0f / (e1.x * e1.x + e1.y * e1.y + e1.z * e1.z);
+  float inv3 = 1.0f / (e3.x * e3.x + e3.y * e3.y + e3.z * e3.z);
+  int j;
+  for (j = 0; j < count; j++) {
+    float px = clipped[j].x - faceCam[0].x;
+    float py = clipped[j].y - faceCam[0].y;
+    float pz = clipped[j].z - faceCam[0].z;
+    float u = clamp01((px * e1.x + py * e1.y + pz * e1.z) * inv1);
+    float v = clamp01((px * e3.x + py * e3.y + pz * e3.z) * inv3);
+    float a = (float)ao[0] + ((float)ao[1] - (float)ao[0]) * u;
+    float b = (float)ao[3] + ((float)ao[2] - (float)ao[3]) * u;
+    shades[j] = (a + (b - a) * v) * (256.0f / 255.0f);
+  }
+}
+
 void drawCube(Cube cube) {
   unsigned char faceMask = cube.visible_faces ? cube.visible_faces : FACE_ALL;
   // Build 8 vertices around center.
@@ -633,13 +1303,23 @@ void drawCube(Cube cube) {
   float cp = VIEW.cp;
   float sp = -VIEW.sp;
 
+  // Object yaw; skip the trig for axis aligned cubes (all maze walls).
+  float oc = 1.0f;
+  float os = 0.0f;
+  if (cube.yaw != 0.0f) {
+    oc = approx_cos(cube.yaw);
+    os = approx_sin(cube.yaw);
+  }
+
   Vec3 verts[8];
   Vec3 camVerts[8];
   int i;
   for (i = 0; i < 8; i++) {
-    float x = (i & 1) ? hs : -hs;
+    float lx = (i & 1) ? hs : -hs;
     float y = (i & 2) ? hs : -hs;
-    float z = (i & 4) ? hs : -hs;
+    float lz = (i & 4) ? hs : -hs;
+    float x = lx * oc - lz * os;
+    float z = lx * os + lz * oc;
     verts[i].x = cube.center.x + x;
     verts[i].y = cube.center.y + y;
     verts[i].z = cube.center.z + z;
@@ -669,6 +1349,9 @@ void drawCube(Cube cube) {
     unsigned char i3 = FACE_VERTS[i][3];
 
     Vec3 n = FACE_NORMALS[i];
+    float nx = n.x * oc - n.z * os;
+    n.z = n.x * os + n.z * oc;
+    n.x = nx;
 
     // Backface cull using world-space normal vs camera position for stability
     // at grazing angles.
@@ -691,10 +1374,12 @@ void drawCube(Cube cube) {
     faceCam[2] = camVerts[i2];
     faceCam[3] = camVerts[i3];
 
-    // Clip against the full frustum to avoid dropping partially visible faces.
+    // Near/far clipping when needed; side planes are handled by the guard
+    // band and the rasterizer clamp.
     Vec3 tmpA[12];
-    Vec3 clipped[12];
-    int clippedCount = clipFrustum(faceCam, 4, tmpA, clipped);
+    Vec3 clipBuf[12];
+    const Vec3 *clipped;
+    int clippedCount = clipFace(faceCam, 4, tmpA, clipBuf, &clipped);
     if (clippedCount < 3)
       continue;
 
@@ -732,19 +1417,40 @@ void drawCube(Cube cube) {
     avgDepth /= (float)clippedCount;
     float fog = fog_factor(avgDepth);
     float brightness = face_brightness(n);
-    unsigned int baseColor = scale_color(cube.color, brightness);
-    unsigned int faceColor = lerp_color(baseColor, FOG_COLOR, fog);
+    FaceShade fs = makeFaceShade(cube.color, brightness, fog);
+
+    if (!cube.ao && view_light_count == 0) {
+      unsigned int faceColor = shadeColor(&fs, 256);
+      // Triangle fan to cover the clipped polygon.
+      for (j = 1; j < clippedCount - 1; j++) {
+        drawFilledTriangle(screen[0][0], screen[0][1], depths[0],
+                           screen[j][0], screen[j][1], depths[j],
+                           screen[j + 1][0], screen[j + 1][1], depths[j + 1],
+                           faceColor);
+      }
+      continue;
+    }
 
-    // Triangle fan to cover the clipped polygon.
+    fs.normal = rotateYawPitch(n, cy, sy, cp, sp);
+    float shades[12];
+    if (!cube.ao) {
+      for (j = 0; j < clippedCount; j++)
+        shades[j] = 256.0f;
+    } else {
+      shadeFace(cube.ao + i * 4, faceCam, clipped, clippedCount, shades);
+    }
     for (j = 1; j < clippedCount - 1; j++) {
-      drawFilledTriangle(screen[0][0], screen[0][1], depths[0], screen[j][0],
-                         screen[j][1], depths[j], screen[j + 1][0],
-                         screen[j + 1][1], depths[j + 1], faceColor);
+      drawShadedTriangle(screen[0][0], screen[0][1], depths[0], shades[0],
+                         screen[j][0], screen[j][1], depths[j], shades[j],
+                         screen[j + 1][0], screen[j + 1][1], depths[j + 1],
+                         shades[j + 1], &fs);
     }
   }
 
   // Edge outlines using unclipped projections to keep wireframe visible when
-  // close.
+  // close. A zero line color means the cube has no outline.
+  if (cube.line_color == 0)
+    return;
   for (i = 0; i < 12; i++) {
     if ((faceMask & EDGE_FACE_BITS[i][0]) == 0 &&
         (faceMask & EDGE_FACE_BITS[i][1]) == 0)
@@ -794,56 +1500,426 @@ const char MAZE[MAZE_H][MAZE_W + 1] = {
     "#.#.#...#", "#.#.#.###", "#...#...#", "#########",
 };
 
-#define MAX_WALLS 128
+// Generated levels replace MAZE with a grid of LEVEL.w x LEVEL.h cells stored
+// one bit per cell (1 = wall), see generateMaze(). Everything below reads
+// cells through levelIsWall(), so both kinds share the wall builder.
+#define GEN_MAX_CELLS (1u << 24) // 2 MiB of wall bits
+#define GEN_MAX_SIDE 8191        // keeps world coordinates precise as floats
+
+typedef struct {
+  unsigned int seed;
+  int w, h;  // 0 x 0 = the hand-written MAZE
+  int braid; // percent of dead ends opened into loops
+} LevelInfo;
+
+LevelInfo LEVEL = {0u, 0, 0, 0};
+static unsigned int GEN_BITS[GEN_MAX_CELLS / 32];
+
+static int genIsWall(int r, int c) {
+  unsigned int i = (unsigned int)r * (unsigned int)LEVEL.w + (unsigned int)c;
+  return (int)((GEN_BITS[i >> 5] >> (i & 31u)) & 1u);
+}
+
+static void genCarve(int r, int c) {
+  unsigned int i = (unsigned int)r * (unsigned int)LEVEL.w + (unsigned int)c;
+  GEN_BITS[i >> 5] &= ~(1u << (i & 31u));
+}
+
+static int levelRows() { return LEVEL.w ? LEVEL.h : MAZE_H; }
+static int levelCols() { return LEVEL.w ? LEVEL.w : MAZE_W; }
+
+static int levelIsWall(int r, int c) {
+  if (r < 0 || r >= levelRows() || c < 0 || c >= levelCols())
+    return 0;
+  return LEVEL.w ? genIsWall(r, c) : MAZE[r][c] == '#';
+}
+
+#define AO_FLOOR 0.3f  // occlusion where a wall meets the floor
+#define AO_CORNER 0.35f // occlusion along a concave corner between walls
+
+// Bake per-vertex ambient occlusion for the wall at cell (r, c). Only the
+// vertical faces are affected: corners darken at the floor and where the cell
+// in front of the face has a wall beside it.
+static void bakeWallAO(Wall *w, int r, int c) {
+  int f, k;
+  for (f = 0; f < 6; f++) {
+    Vec3 n = FACE_NORMALS[f];
+    for (k = 0; k < 4; k++) {
+      unsigned char v = FACE_VERTS[f][k];
+      float occ = 0.0f;
+      if (n.y == 0.0f) {
+        // Cell in front of the face, then step along the face tangent
+        // towards this vertex.
+        int fr = r + (int)n.z;
+        int fc = c + (int)n.x;
+        if (n.x != 0.0f)
+          fr += (v & 4) ? 1 : -1;
+        else
+          fc += (v & 1) ? 1 : -1;
+        if (!(v & 2))
+          occ += AO_FLOOR;
+        if (levelIsWall(fr, fc))
+          occ += AO_CORNER;
+      }
+      w->ao[f][k] = (unsigned char)(255.0f * (1.0f - occ) + 0.5f);
+    }
+  }
+}
+
+// Generated levels only build walls for a window of cells around the camera.
+// Walls more than LEVEL_VIEW_CELLS away are at least 34 units off, past the
+// fog limit even at the screen edges, so they would draw as background.
+#define LEVEL_VIEW_CELLS 18
+#define LEVEL_WINDOW_STEP 4 // window centers snap to this grid of cells
+#define LEVEL_WINDOW_RADIUS (LEVEL_VIEW_CELLS + LEVEL_WINDOW_STEP / 2)
+#define LEVEL_WINDOW (2 * LEVEL_WINDOW_RADIUS + 1)
+
+#define MAX_WALLS (LEVEL_WINDOW * LEVEL_WINDOW)
+#define CELL_SIZE 2.0f
+#define WALL_HEIGHT 1.6f
+#define NO_WALL -1
+
+// One wall cube for the wall cell (r, c), with faces against neighboring
+// walls masked off and vertex occlusion baked in.
+static void buildWall(Wall *w, int r, int c) {
+  float x0 = (float)c * CELL_SIZE;
+  float z0 = (float)r * CELL_SIZE;
+  w->minx = x0;
+  w->minz = z0;
+  w->maxx = x0 + CELL_SIZE;
+  w->maxz = z0 + CELL_SIZE;
+  w->height = WALL_HEIGHT;
+  w->color = 0xff475569; // slate gray
+  unsigned char mask = FACE_ALL;
+  if (levelIsWall(r - 1, c))
+    mask &= ~FACE_BACK; // neighbor to north
+  if (levelIsWall(r + 1, c))
+    mask &= ~FACE_FRONT; // neighbor to south
+  if (levelIsWall(r, c - 1))
+    mask &= ~FACE_LEFT; // neighbor to west
+  if (levelIsWall(r, c + 1))
+    mask &= ~FACE_RIGHT; // neighbor to east
+  w->visible_faces = mask;
+  bakeWallAO(w, r, c);
+}
+
+// Runtime builder for the hand-written MAZE: one wall per '#' cell. grid
+// receives the wall index of every cell (NO_WALL for floor) for collision
+// lookups. Returns the number of walls written.
+int buildWalls(Wall *walls, int maxWalls, short grid[MAZE_H][MAZE_W]) {
+  int count = 0;
+  int r, c;
+  for (r = 0; r < MAZE_H; r++) {
+    for (c = 0; c < MAZE_W; c++) {
+      grid[r][c] = NO_WALL;
+      if (MAZE[r][c] == '#' && count < maxWalls) {
+        buildWall(&walls[count], r, c);
+        grid[r][c] = (short)count;
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
 Wall WALLS[MAX_WALLS];
+short WALL_GRID[MAZE_H][MAZE_W];
+int MINIMAP_DIRTY = 1; // set whenever the scene walls change
+
+// The scene reads walls through these pointers. Builds with MAZE_BAKED start
+// on the tables generated by bake_maze (see Makefile) and never run the
+// builder; otherwise buildMaze() fills WALLS on the first frame.
+#ifdef MAZE_BAKED
+#include "maze_baked.h"
+const Wall *SCENE_WALLS = BAKED_WALLS;
+const short (*SCENE_GRID)[MAZE_W] = BAKED_WALL_GRID;
+int WALL_COUNT = BAKED_WALL_COUNT;
+#else
+const Wall *SCENE_WALLS = WALLS;
+const short (*SCENE_GRID)[MAZE_W] = WALL_GRID;
 int WALL_COUNT = 0;
+#endif
+
+// Rebuild WALLS when the camera enters another LEVEL_WINDOW_STEP block. The
+// window depends only on the camera's cell, so replays see the same walls
+// whatever path led there.
+static int window_r = 0;
+static int window_c = 0;
+static int window_valid = 0;
+
+static int windowCenter(float coord) {
+  int cell = coord > 0.0f ? (int)(coord * (1.0f / CELL_SIZE)) : 0;
+  return cell - cell % LEVEL_WINDOW_STEP + LEVEL_WINDOW_STEP / 2;
+}
+
+static void buildLevelWindow() {
+  int cr = windowCenter(camera_pos.z);
+  int cc = windowCenter(camera_pos.x);
+  if (window_valid && cr == window_r && cc == window_c)
+    return;
+  window_r = cr;
+  window_c = cc;
+  window_valid = 1;
+
+  int r0 = cr - LEVEL_WINDOW_RADIUS;
+  int r1 = cr + LEVEL_WINDOW_RADIUS;
+  int c0 = cc - LEVEL_WINDOW_RADIUS;
+  int c1 = cc + LEVEL_WINDOW_RADIUS;
+  if (r0 < 0)
+    r0 = 0;
+  if (c0 < 0)
+    c0 = 0;
+  if (r1 >= LEVEL.h)
+    r1 = LEVEL.h - 1;
+  if (c1 >= LEVEL.w)
+    c1 = LEVEL.w - 1;
+  int count = 0;
+  int r, c;
+  for (r = r0; r <= r1; r++) {
+    for (c = c0; c <= c1; c++) {
+      if (genIsWall(r, c))
+        buildWall(&WALLS[count++], r, c);
+    }
+  }
+  WALL_COUNT = count;
+  SCENE_WALLS = WALLS;
+  MINIMAP_DIRTY = 1;
+}
 
 void buildMaze() {
+  if (LEVEL.w) {
+    buildLevelWindow();
+    return;
+  }
   if (WALL_COUNT > 0)
     return;
+  WALL_COUNT = buildWalls(WALLS, MAX_WALLS, WALL_GRID);
+  SCENE_WALLS = WALLS;
+  SCENE_GRID = WALL_GRID;
+  MINIMAP_DIRTY = 1;
+}
+
+// Only the cells under the player's bounding square can hold a hit. The
+// hand-written maze looks walls up through SCENE_GRID; generated levels test
+// the cell bits directly, since WALLS only covers the window.
+int collides(float x, float z, float y) {
+  int c0 = (int)((x - player_radius) * (1.0f / CELL_SIZE));
+  int c1 = (int)((x + player_radius) * (1.0f / CELL_SIZE));
+  int r0 = (int)((z - player_radius) * (1.0f / CELL_SIZE));
+  int r1 = (int)((z + player_radius) * (1.0f / CELL_SIZE));
+  if (x - player_radius < 0.0f)
+    c0 = 0;
+  if (z - player_radius < 0.0f)
+    r0 = 0;
+  if (c1 >= levelCols())
+    c1 = levelCols() - 1;
+  if (r1 >= levelRows())
+    r1 = levelRows() - 1;
   int r, c;
-  for (r = 0; r < MAZE_H; r++) {
-    for (c = 0; c < MAZE_W; c++) {
-      if (MAZE[r][c] == '#') {
-        // Each cell is 2 units wide.
-        float x0 = (float)c * 2.0f;
-        float z0 = (float)r * 2.0f;
-        if (WALL_COUNT < MAX_WALLS) {
-          WALLS[WALL_COUNT].minx = x0;
-          WALLS[WALL_COUNT].minz = z0;
-          WALLS[WALL_COUNT].maxx = x0 + 2.0f;
-          WALLS[WALL_COUNT].maxz = z0 + 2.0f;
-          WALLS[WALL_COUNT].height = 1.6f;
-          WALLS[WALL_COUNT].color = 0xff475569; // slate gray
-          unsigned char mask = FACE_ALL;
-          if (r > 0 && MAZE[r - 1][c] == '#')
-            mask &= ~FACE_BACK; // neighbor to north
-          if (r < MAZE_H - 1 && MAZE[r + 1][c] == '#')
-            mask &= ~FACE_FRONT; // neighbor to south
-          if (c > 0 && MAZE[r][c - 1] == '#')
-            mask &= ~FACE_LEFT; // neighbor to west
-          if (c < MAZE_W - 1 && MAZE[r][c + 1] == '#')
-            mask &= ~FACE_RIGHT; // neighbor to east
-          WALLS[WALL_COUNT].visible_faces = mask;
-          WALL_COUNT++;
-        }
+  for (r = r0; r <= r1; r++) {
+    for (c = c0; c <= c1; c++) {
+      float minx, minz, maxx, maxz, height;
+      if (LEVEL.w) {
+        if (!genIsWall(r, c))
+          continue;
+        minx = (float)c * CELL_SIZE;
+        minz = (float)r * CELL_SIZE;
+        maxx = minx + CELL_SIZE;
+        maxz = minz + CELL_SIZE;
+        height = WALL_HEIGHT;
+      } else {
+        int i = SCENE_GRID[r][c];
+        if (i == NO_WALL)
+          continue;
+        const Wall *w = &SCENE_WALLS[i];
+        minx = w->minx;
+        minz = w->minz;
+        maxx = w->maxx;
+        maxz = w->maxz;
+        height = w->height;
+      }
+      if (y > height)
+        continue;
+      if (x > minx - player_radius && x < maxx + player_radius &&
+          z > minz - player_radius && z < maxz + player_radius) {
+        return 1;
       }
     }
   }
+  return 0;
 }
 
-int collides(float x, float z, float y) {
-  int i;
-  for (i = 0; i < WALL_COUNT; i++) {
-    Wall w = WALLS[i];
-    if (y > w.height)
+// --------- Maze generation ---------
+// Rooms sit on odd rows and columns; room (i, j) is cell (2i + 1, 2j + 1) and
+// the cell between two rooms is the passage joining them. Generation is a
+// randomized depth-first search that keeps no stack: a room is visited once
+// its cell is carved, and each room stores the direction back to its parent
+// in 2 bits, so the walk backtracks by reading them. Every room is entered
+// once and left once, so the cost is linear in the cell count.
+static unsigned int GEN_BACK[GEN_MAX_CELLS / 4 / 16]; // 2 bits per room
+static unsigned int gen_rng = 1u;
+
+// Directions: north, south, west, east; d ^ 1 is the opposite one.
+static const int DIR_DR[4] = {-1, 1, 0, 0};
+static const int DIR_DC[4] = {0, 0, -1, 1};
+
+static unsigned int genRandom() { // xorshift32
+  unsigned int x = gen_rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  gen_rng = x;
+  return x;
+}
+
+static unsigned int genPick(unsigned int n) {
+  return (unsigned int)(((unsigned long long)genRandom() * n) >> 32);
+}
+
+static void setBackDir(unsigned int room, int d) {
+  unsigned int shift = (room & 15u) * 2u;
+  GEN_BACK[room >> 4] = (GEN_BACK[room >> 4] & ~(3u << shift)) |
+                        ((unsigned int)d << shift);
+}
+
+static int backDir(unsigned int room) {
+  return (int)((GEN_BACK[room >> 4] >> ((room & 15u) * 2u)) & 3u);
+}
+
+static void carveRooms(int rows, int cols) {
+  int i = 0, j = 0;
+  genCarve(1, 1);
+  while (1) {
+    int options[4];
+    int n = 0;
+    int d;
+    for (d = 0; d < 4; d++) {
+      int ni = i + DIR_DR[d];
+      int nj = j + DIR_DC[d];
+      if (ni >= 0 && ni < rows && nj >= 0 && nj < cols &&
+          genIsWall(2 * ni + 1, 2 * nj + 1))
+        options[n++] = d;
+    }
+    if (n > 0) {
+      d = options[genPick((unsigned int)n)];
+      genCarve(2 * i + 1 + DIR_DR[d], 2 * j + 1 + DIR_DC[d]);
+      i += DIR_DR[d];
+      j += DIR_DC[d];
+      genCarve(2 * i + 1, 2 * j + 1);
+      setBackDir((unsigned int)(i * cols + j), d ^ 1);
       continue;
-    if (x > w.minx - player_radius && x < w.maxx + player_radius &&
-        z > w.minz - player_radius && z < w.maxz + player_radius) {
-      return 1;
     }
+    if (i == 0 && j == 0)
+      break;
+    d = backDir((unsigned int)(i * cols + j));
+    i += DIR_DR[d];
+    j += DIR_DC[d];
   }
-  return 0;
+}
+
+static int roomExits(int i, int j) {
+  int d, n = 0;
+  for (d = 0; d < 4; d++)
+    n += !genIsWall(2 * i + 1 + DIR_DR[d], 2 * j + 1 + DIR_DC[d]);
+  return n;
+}
+
+// Open one more passage out of `percent` of the dead ends, preferring a
+// neighbor that is a dead end too. Each opening adds a loop.
+static void braidRooms(int rows, int cols, int percent) {
+  int i, j;
+  for (i = 0; i < rows; i++) {
+    for (j = 0; j < cols; j++) {
+      if (roomExits(i, j) != 1 || (int)genPick(100u) >= percent)
+        continue;
+      int options[4];
+      int n = 0, deadEnds = 0;
+      int d;
+      for (d = 0; d < 4; d++) {
+        int ni = i + DIR_DR[d];
+        int nj = j + DIR_DC[d];
+        if (ni < 0 || ni >= rows || nj < 0 || nj >= cols ||
+            !genIsWall(2 * i + 1 + DIR_DR[d], 2 * j + 1 + DIR_DC[d]))
+          continue;
+        if (roomExits(ni, nj) == 1) {
+          // Dead-end neighbors go first.
+          options[n++] = options[deadEnds];
+          options[deadEnds++] = d;
+        } else {
+          options[n++] = d;
+        }
+      }
+      if (n == 0)
+        continue;
+      d = options[genPick((unsigned int)(deadEnds ? deadEnds : n))];
+      genCarve(2 * i + 1 + DIR_DR[d], 2 * j + 1 + DIR_DC[d]);
+    }
+  }
+}
+
+static void spawnPlayer(float x, float z) {
+  camera_pos.x = x;
+  camera_pos.z = z;
+  player_y = 0.0f;
+  player_y_vel = 0.0f;
+  player_grounded = 1;
+  camera_pos.y = player_height;
+}
+
+// Builds a seeded maze of w x h cells (rounded down to odd sizes, at least
+// 5 x 5) and moves the player into its first room. braid is the percentage of
+// dead ends to open up: 0 gives a perfect maze (exactly one path between any
+// two rooms). w = h = 0 switches back to the hand-written MAZE. Returns 0 and
+// keeps the current level if the size is out of range.
+int generateMaze(unsigned int seed, int w, int h, int braid) {
+  if (w == 0 && h == 0) {
+    LEVEL.seed = 0u;
+    LEVEL.w = 0;
+    LEVEL.h = 0;
+    LEVEL.braid = 0;
+#ifdef MAZE_BAKED
+    SCENE_WALLS = BAKED_WALLS;
+    SCENE_GRID = BAKED_WALL_GRID;
+    WALL_COUNT = BAKED_WALL_COUNT;
+#else
+    WALL_COUNT = 0; // buildMaze() rebuilds MAZE on the next frame
+#endif
+    MINIMAP_DIRTY = 1;
+    spawnPlayer(2.5f, 2.5f);
+    return 1;
+  }
+  w -= !(w & 1);
+  h -= !(h & 1);
+  if (w < 5 || h < 5 || w > GEN_MAX_SIDE || h > GEN_MAX_SIDE ||
+      (unsigned int)w * (unsigned int)h > GEN_MAX_CELLS)
+    return 0;
+  if (braid < 0)
+    braid = 0;
+  if (braid > 100)
+    braid = 100;
+  LEVEL.seed = seed;
+  LEVEL.w = w;
+  LEVEL.h = h;
+  LEVEL.braid = braid;
+
+  // Mix the seed so nearby seeds give unrelated mazes; xorshift needs x != 0.
+  gen_rng = (seed ^ 0x9e3779b9u) * 2654435761u;
+  gen_rng ^= gen_rng >> 16;
+  if (gen_rng == 0)
+    gen_rng = 1u;
+
+  unsigned int cells = (unsigned int)w * (unsigned int)h;
+  __builtin_memset(GEN_BITS, 0xff, ((cells + 31u) / 32u) * 4u);
+  int rows = (h - 1) / 2;
+  int cols = (w - 1) / 2;
+  carveRooms(rows, cols);
+  if (braid > 0)
+    braidRooms(rows, cols, braid);
+
+  window_valid = 0;
+  spawnPlayer(1.5f * CELL_SIZE, 1.5f * CELL_SIZE);
+  buildLevelWindow();
+  return 1;
 }
 
 void updateCamera() {
@@ -925,24 +2001,615 @@ void updateCamera() {
   INPUT_MOUSE_DY = 0;
 }
 
+// --------- Temporal reprojection ---------
+// With TEMPORAL_MODE on and the camera moving smoothly, the world pass only
+// draws every other row, alternating each frame. drawHud() rebuilds the
+// skipped rows from the previous frame. Pixels whose rendered neighbors agree
+// copy them; the rest borrow the nearer neighbor's depth, are moved into the
+// previous camera and take the color found there if the stored depth agrees.
+// Misses (disocclusions, screen edges) copy the neighbor instead. Large camera
+// moves render a full frame.
+int TEMPORAL_MODE = 0;
+const float TEMPORAL_MAX_MOVE = 0.3f;  // world units per frame (sprint 0.14)
+const float TEMPORAL_MAX_TURN = 0.08f; // radians per frame, yaw or pitch
+const float TEMPORAL_DEPTH_TOLERANCE = 0.05f; // relative 1/z mismatch
+
+static const unsigned int *HISTORY;
+static const DepthValue *HISTORY_DEPTH;
+static Vec3 history_pos;
+static ViewBasis history_view;
+static int history_valid = 0;
+static unsigned int temporal_frame = 0;
+
+void setTemporalMode(int on) {
+  TEMPORAL_MODE = on != 0;
+  history_valid = 0;
+}
+
+static void beginTemporalFrame() {
+  RASTER_ROW_PARITY = -1;
+  if (!TEMPORAL_MODE)
+    return;
+  // Leave the last frame's buffers untouched as the history.
+  int next = BUFFER == FRAME_BUFFERS[0];
+  BUFFER = FRAME_BUFFERS[next];
+  DEPTH = DEPTH_BUFFERS[next];
+  if (!history_valid)
+    return;
+  float dx = camera_pos.x - history_pos.x;
+  float dy = camera_pos.y - history_pos.y;
+  float dz = camera_pos.z - history_pos.z;
+  // Chord lengths on the unit circle stand in for the turn angles.
+  float yc = VIEW.cy - history_view.cy;
+  float ys = VIEW.sy - history_view.sy;
+  float pc = VIEW.cp - history_view.cp;
+  float ps = VIEW.sp - history_view.sp;
+  float maxTurn2 = TEMPORAL_MAX_TURN * TEMPORAL_MAX_TURN;
+  if (dx * dx + dy * dy + dz * dz > TEMPORAL_MAX_MOVE * TEMPORAL_MAX_MOVE ||
+      yc * yc + ys * ys > maxTurn2 || pc * pc + ps * ps > maxTurn2)
+    return;
+  RASTER_ROW_PARITY = (int)(temporal_frame & 1u);
+  temporal_frame++;
+}
+
+// Inverse of the camera rotation applied in drawCube (pitch, then yaw).
+static Vec3 viewToWorldDir(Vec3 p, const ViewBasis *v) {
+  float cy = v->cy;
+  float sy = -v->sy;
+  float cp = v->cp;
+  float sp = -v->sp;
+  float rz = -p.y * sp + p.z * cp;
+  Vec3 out;
+  out.y = p.y * cp + p.z * sp;
+  out.x = p.x * cy + rz * sy;
+  out.z = -p.x * sy + rz * cy;
+  return out;
+}
+
+static Vec3 worldToViewDir(Vec3 d, const ViewBasis *v) {
+  return rotateYawPitch(d, v->cy, -v->sy, v->cp, -v->sp);
+}
+
+static void reconstructRows(int parity) {
+  // Current camera space to previous camera space: p' = M p + t.
+  Vec3 axis[3] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+  Vec3 m[3];
+  int k;
+  for (k = 0; k < 3; k++)
+    m[k] = worldToViewDir(viewToWorldDir(axis[k], &VIEW), &history_view);
+  Vec3 move;
+  move.x = camera_pos.x - history_pos.x;
+  move.y = camera_pos.y - history_pos.y;
+  move.z = camera_pos.z - history_pos.z;
+  Vec3 t = worldToViewDir(move, &history_view);
+
+  int y;
+  for (y = parity; y < (int)HEIGHT; y += 2) {
+    unsigned int up = (unsigned int)(y > 0 ? y - 1 : y + 1) * WIDTH;
+    unsigned int down =
+        (unsigned int)(y + 1 < (int)HEIGHT ? y + 1 : y - 1) * WIDTH;
+    unsigned int row = (unsigned int)y * WIDTH;
+    // View ray (rx, ry, 1) through the pixel center, rx added per column.
+    float ry = (HALF_HEIGHT - (float)y - 0.5f) * (1.0f / HALF_HEIGHT);
+    Vec3 base;
+    base.x = m[1].x * ry + m[2].x;
+    base.y = m[1].y * ry + m[2].y;
+    base.z = m[1].z * ry + m[2].z;
+    unsigned int x;
+    // WIDTH is a multiple of 4: the projection math runs four pixels at a
+    // time, history lookups stay per pixel.
+    for (x = 0; x < WIDTH; x += 4) {
+      // Borrow depth and color from the nearer rendered neighbor.
+      f32x4 keyUp = loadDepth4(&DEPTH[up + x]);
+      f32x4 keyDown = loadDepth4(&DEPTH[down + x]);
+      i32x4 takeDown = keyDown > keyUp;
+      f32x4 key = (f32x4)(((i32x4)keyDown & takeDown) |
+                          ((i32x4)keyUp & ~takeDown));
+      i32x4 colorUp, colorDown;
+      __builtin_memcpy(&colorUp, &BUFFER[up + x], sizeof(colorUp));
+      __builtin_memcpy(&colorDown, &BUFFER[down + x], sizeof(colorDown));
+      i32x4 color = (colorDown & takeDown) | (colorUp & ~takeDown);
+      int k2;
+      for (k2 = 0; k2 < 4; k2++)
+        DEPTH[row + x + k2] = takeDown[k2] ? DEPTH[down + x + k2]
+                                           : DEPTH[up + x + k2];
+      // Where both neighbors agree the pixel sits inside a flat span and the
+      // neighbor color is already right; only edges need the history.
+      i32x4 edge = colorUp != colorDown;
+      if (!anyLane(edge)) {
+        __builtin_memcpy(&BUFFER[row + x], &color, sizeof(color));
+        continue;
+      }
+
+      // Work with p'/z so one reciprocal gives both the projection and the
+      // previous 1/z.
+      f32x4 invZ = keyToInvZ4(key);
+      f32x4 rx = ((float)x + 0.5f - HALF_WIDTH + LANE_X) * (1.0f / HALF_WIDTH);
+      f32x4 pz = m[0].z * rx + base.z + t.z * invZ;
+      i32x4 ok = edge & (key != (float)DEPTH_CLEAR) & (pz > NEAR_PLANE * invZ);
+      f32x4 q = 1.0f / pz;
+      f32x4 px = (m[0].x * rx + base.x + t.x * invZ) * q;
+      f32x4 py = (m[0].y * rx + base.y + t.y * invZ) * q;
+      i32x4 hx = __builtin_convertvector(px * HALF_WIDTH + HALF_WIDTH, i32x4);
+      i32x4 hy =
+          __builtin_convertvector(-py * HALF_HEIGHT + HALF_HEIGHT, i32x4);
+      ok &= (hx >= 0) & (hx < (int)WIDTH) & (hy >= 0) & (hy < (int)HEIGHT);
+      f32x4 prevInvZ = invZ * q;
+      int l;
+      for (l = 0; l < 4; l++) {
+        if (!ok[l])
+          continue;
+        unsigned int hidx = (unsigned int)hy[l] * WIDTH + (unsigned int)hx[l];
+        float diff = keyToInvZ((float)HISTORY_DEPTH[hidx]) - prevInvZ[l];
+        if (diff < 0.0f)
+          diff = -diff;
+        if (diff <= TEMPORAL_DEPTH_TOLERANCE * prevInvZ[l])
+          color[l] = (int)HISTORY[hidx];
+      }
+      __builtin_memcpy(&BUFFER[row + x], &color, sizeof(color));
+    }
+  }
+}
+
+// Fill in the rows an interlaced frame skipped and keep the finished frame as
+// history; the next frame draws into the other buffers. Called by drawHud()
+// before any overlay is drawn.
+static void resolveTemporalFrame() {
+  int parity = RASTER_ROW_PARITY;
+  RASTER_ROW_PARITY = -1;
+  if (!TEMPORAL_MODE)
+    return;
+  if (parity >= 0)
+    reconstructRows(parity ^ 1);
+  HISTORY = BUFFER;
+  HISTORY_DEPTH = DEPTH;
+  history_pos = camera_pos;
+  history_view = VIEW;
+  history_valid = 1;
+}
+
+// --------- Input traces ---------
+// While TRACE_RECORDING is set, showCanvas() appends the input that drives
+// the frame (keys, mouse deltas, flashlight and interlacing) to a ring of
+// 6-byte frames. The ring is split into chunks that each remember the player
+// state they started from, so a full ring still exports a replayable trace
+// beginning at its oldest whole chunk. Each chunk also starts without
+// interlacing history (the first frame renders in full) and records the row
+// parity, so a replay from any chunk sees the same interlaced frames. The
+// header names the level and holds the point lights of the first recorded
+// frame (lights only change with the level, and switching levels restarts
+// the recording).
+// exportTrace() and loadTrace() move traces through TRACE_FILE: a TraceHeader
+// followed by the frames in order, little-endian, which is also the file
+// format.
+#define TRACE_MAGIC 0x52545a4du // "MZTR"
+#define TRACE_VERSION 4u // 2 added the level, 3 the interlace parity, 4 lights
+#define TRACE_CHUNK_FRAMES 1024u
+#define TRACE_CHUNKS 64u
+#define TRACE_CAPACITY (TRACE_CHUNK_FRAMES * TRACE_CHUNKS) // ~18 min at 60 Hz
+#define TRACE_MODE_FLASHLIGHT 1u
+#define TRACE_MODE_TEMPORAL 2u
+
+typedef struct {
+  Vec3 pos;
+  float yaw, pitch;
+  float player_y, player_y_vel;
+  int grounded;
+  unsigned int temporal_frame; // only its parity matters
+} TraceState;
+
+typedef struct {
+  unsigned int magic;
+  unsigned int version;
+  unsigned int frame_count;
+  LevelInfo level;
+  TraceState start;
+  int light_count;
+  PointLight lights[MAX_LIGHTS]; // unused entries are zero
+} TraceHeader;
+
+typedef struct {
+  unsigned char keys;
+  unsigned char modes; // TRACE_MODE_* bits
+  short mouse_dx;
+  short mouse_dy;
+} TraceFrame;
+
+int TRACE_RECORDING = 0;
+static TraceFrame TRACE_FRAMES[TRACE_CAPACITY];
+static TraceState TRACE_CHUNK_START[TRACE_CHUNKS];
+static unsigned int trace_written = 0; // frames appended since recording began
+static LevelInfo trace_level;
+static int trace_light_count;
+static PointLight trace_lights[MAX_LIGHTS];
+unsigned char TRACE_FILE[sizeof(TraceHeader) +
+                         TRACE_CAPACITY * sizeof(TraceFrame)]
+    __attribute__((aligned(4)));
+
+static short clampShort(int v) {
+  return (short)(v < -32768 ? -32768 : v > 32767 ? 32767 : v);
+}
+
+static void saveTraceState(TraceState *s) {
+  s->pos = camera_pos;
+  s->yaw = camera_yaw;
+  s->pitch = camera_pitch;
+  s->player_y = player_y;
+  s->player_y_vel = player_y_vel;
+  s->grounded = player_grounded;
+  s->temporal_frame = temporal_frame;
+}
+
+static int sameLevel(const LevelInfo *a, const LevelInfo *b) {
+  return a->seed == b->seed && a->w == b->w && a->h == b->h &&
+         a->braid == b->braid;
+}
+
+void startTraceRecording() {
+  trace_written = 0;
+  trace_level = LEVEL;
+  TRACE_RECORDING = 1;
+}
+
+void stopTraceRecording() { TRACE_RECORDING = 0; }
+
+static void recordTraceFrame() {
+  if (!sameLevel(&trace_level, &LEVEL))
+    startTraceRecording();
+  if (trace_written == 0) {
+    trace_light_count = LIGHT_COUNT;
+    __builtin_memset(trace_lights, 0, sizeof(trace_lights));
+    __builtin_memcpy(trace_lights, LIGHTS,
+                     (unsigned int)LIGHT_COUNT * sizeof(PointLight));
+  }
+  unsigned int slot = trace_written % TRACE_CAPACITY;
+  if (slot % TRACE_CHUNK_FRAMES == 0) {
+    saveTraceState(&TRACE_CHUNK_START[slot / TRACE_CHUNK_FRAMES]);
+    history_valid = 0;
+  }
+  TraceFrame *f = &TRACE_FRAMES[slot];
+  f->keys = (unsigned char)INPUT_KEYS;
+  f->modes = (unsigned char)((FLASHLIGHT_ON ? TRACE_MODE_FLASHLIGHT : 0u) |
+                             (TEMPORAL_MODE ? TRACE_MODE_TEMPORAL : 0u));
+  f->mouse_dx = clampShort(INPUT_MOUSE_DX);
+  f->mouse_dy = clampShort(INPUT_MOUSE_DY);
+  trace_written++;
+}
+
+// Writes the recorded trace to TRACE_FILE and returns its size in bytes.
+int exportTrace() {
+  unsigned int first = 0;
+  if (trace_written > TRACE_CAPACITY) {
+    // The chunk under the write cursor is partly overwritten; start after it.
+    first = trace_written - TRACE_CAPACITY + TRACE_CHUNK_FRAMES - 1;
+    first -= first % TRACE_CHUNK_FRAMES;
+  }
+  TraceHeader h;
+  h.magic = TRACE_MAGIC;
+  h.version = TRACE_VERSION;
+  h.frame_count = trace_written - first;
+  h.level = trace_level;
+  h.start = TRACE_CHUNK_START[(first % TRACE_CAPACITY) / TRACE_CHUNK_FRAMES];
+  h.light_count = trace_light_count;
+  __builtin_memcpy(h.lights, trace_lights, sizeof(h.lights));
+  __builtin_memcpy(TRACE_FILE, &h, sizeof(h));
+  TraceFrame *out = (TraceFrame *)(TRACE_FILE + sizeof(h));
+  unsigned int i;
+  for (i = 0; i < h.frame_count; i++)
+    out[i] = TRACE_FRAMES[(first + i) % TRACE_CAPACITY];
+  return (int)(sizeof(h) + h.frame_count * sizeof(TraceFrame));
+}
+
 void showCanvas() {
   buildMaze();
+  if (TRACE_RECORDING)
+    recordTraceFrame();
   updateCamera();
+  cullLights();
+  beginTemporalFrame();
   clearBuffer(0xff111827); // dark background
 
   int i;
   for (i = 0; i < WALL_COUNT; i++) {
-    Wall w = WALLS[i];
+    const Wall *w = &SCENE_WALLS[i];
     Cube c;
-    c.center.x = (w.minx + w.maxx) * 0.5f;
-    c.center.y = w.height * 0.5f - 0.1f;
-    c.center.z = (w.minz + w.maxz) * 0.5f;
-    c.size = (w.maxx - w.minx); // assumes square cell
-    c.color = w.color;
+    c.center.x = (w->minx + w->maxx) * 0.5f;
+    c.center.y = w->height * 0.5f - 0.1f;
+    c.center.z = (w->minz + w->maxz) * 0.5f;
+    c.size = (w->maxx - w->minx); // assumes square cell
+    c.color = w->color;
     c.line_color = 0xffe2e8f0;
-    c.visible_faces = w.visible_faces;
+    c.visible_faces = w->visible_faces;
+    c.yaw = 0.0f;
+    c.ao = &w->ao[0][0];
     drawCube(c);
   }
+}
+
+// --------- Dynamic instances ---------
+// Moving objects (pickups, other players) are written by JS straight into
+// linear memory; every field is 4 bytes so a Float32Array and a Uint32Array
+// over INSTANCES can share one layout of 8 words per slot.
+typedef struct {
+  float x; // center
+  float y;
+  float z;
+  float size;                 // edge length, <= 0 marks the slot as empty
+  float yaw;                  // radians around +y
+  unsigned int color;         // 0xAARRGGBB
+  unsigned int line_color;    // 0xAARRGGBB, 0 = no outline
+  unsigned int visible_faces; // FACE_* bits, 0 = all faces
+} Instance;
+
+#define MAX_INSTANCES 256
+Instance INSTANCES[MAX_INSTANCES];
+int INSTANCE_HIGH_WATER = 0; // one past the highest slot ever acquired
+
+// Free slot stack so acquire/release never scan or allocate. It starts in
+// ascending order, so a fresh pool hands out 0, 1, 2, ...; after that the
+// most recently released slot is reused first. INSTANCE_LIVE has one bit per
+// acquired slot so a double release cannot put a slot on the stack twice.
+static unsigned short INSTANCE_FREE[MAX_INSTANCES];
+static unsigned int INSTANCE_LIVE[MAX_INSTANCES / 32];
+static int instance_free_count = 0;
+static int instance_pool_ready = 0;
+
+int acquireInstance() {
+  if (!instance_pool_ready) {
+    int i;
+    for (i = 0; i < MAX_INSTANCES; i++)
+      INSTANCE_FREE[i] = (unsigned short)(MAX_INSTANCES - 1 - i);
+    instance_free_count = MAX_INSTANCES;
+    instance_pool_ready = 1;
+  }
+  if (instance_free_count == 0)
+    return -1;
+  int slot = INSTANCE_FREE[--instance_free_count];
+  INSTANCE_LIVE[slot >> 5] |= 1u << (slot & 31);
+  INSTANCES[slot].size = 0.0f; // stays hidden until JS fills it in
+  if (slot >= INSTANCE_HIGH_WATER)
+    INSTANCE_HIGH_WATER = slot + 1;
+  return slot;
+}
+
+// Returns 0 (and changes nothing) for a slot that is not currently acquired.
+int releaseInstance(int slot) {
+  if ((unsigned int)slot >= MAX_INSTANCES)
+    return 0;
+  unsigned int bit = 1u << (slot & 31);
+  if (!(INSTANCE_LIVE[slot >> 5] & bit))
+    return 0;
+  INSTANCE_LIVE[slot >> 5] &= ~bit;
+  INSTANCES[slot].size = 0.0f;
+  INSTANCE_FREE[instance_free_count++] = (unsigned short)slot;
+  return 1;
+}
+
+// Draw every acquired slot on top of the current frame, depth tested against
+// the maze. Call after showCanvas() and before drawHud().
+void drawInstances() {
+  int count = INSTANCE_HIGH_WATER;
+  float cy = VIEW.cy;
+  float sy = -VIEW.sy;
+  float cp = VIEW.cp;
+  float sp = -VIEW.sp;
+  int i;
+  for (i = 0; i < count; i++) {
+    const Instance *inst = &INSTANCES[i];
+    if (!(inst->size > 0.0f))
+      continue;
+
+    // Bounding sphere against the frustum before building any vertices.
+    Vec3 rel;
+    rel.x = inst->x - camera_pos.x;
+    rel.y = inst->y - camera_pos.y;
+    rel.z = inst->z - camera_pos.z;
+    Vec3 c = rotateYawPitch(rel, cy, sy, cp, sp);
+    float r = inst->size * 0.8660254f; // half the cube diagonal
+    if (c.z + r < NEAR_PLANE || c.z - r > FAR_PLANE)
+      continue;
+    float side = -r * FRUSTUM_GUARD_NORM;
+    if (c.x + FRUSTUM_GUARD * c.z < side || -c.x + FRUSTUM_GUARD * c.z < side ||
+        -c.y + FRUSTUM_GUARD * c.z < side || c.y + FRUSTUM_GUARD * c.z < side)
+      continue;
+
+    Cube cube;
+    cube.center.x = inst->x;
+    cube.center.y = inst->y;
+    cube.center.z = inst->z;
+    cube.size = inst->size;
+    cube.color = inst->color;
+    cube.line_color = inst->line_color;
+    cube.visible_faces = (unsigned char)(inst->visible_faces & FACE_ALL);
+    cube.yaw = inst->yaw;
+    cube.ao = 0;
+    drawCube(cube);
+  }
+}
+
+// --------- Minimap ---------
+// The wall layout is static, so it is rasterized once into MINIMAP and only
+// copied into a corner of BUFFER each frame.
+#define MINIMAP_SIZE 120u
+#define MINIMAP_MARGIN 10u
+unsigned int MINIMAP[MINIMAP_SIZE * MINIMAP_SIZE];
+static float minimap_scale = 1.0f; // minimap pixels per world unit
+static float minimap_origin_x = 0.0f; // world position of the top-left corner
+static float minimap_origin_z = 0.0f;
+
+static void fillMinimapRect(float x0, float z0, float x1, float z1,
+                            unsigned int color) {
+  int px0 = (int)((x0 - minimap_origin_x) * minimap_scale);
+  int py0 = (int)((z0 - minimap_origin_z) * minimap_scale);
+  int px1 = (int)((x1 - minimap_origin_x) * minimap_scale);
+  int py1 = (int)((z1 - minimap_origin_z) * minimap_scale);
+  if (px0 < 0)
+    px0 = 0;
+  if (py0 < 0)
+    py0 = 0;
+  if (px1 > (int)MINIMAP_SIZE)
+    px1 = (int)MINIMAP_SIZE;
+  if (py1 > (int)MINIMAP_SIZE)
+    py1 = (int)MINIMAP_SIZE;
+  int x, y;
+  for (y = py0; y < py1; y++) {
+    for (x = px0; x < px1; x++) {
+      MINIMAP[(unsigned int)y * MINIMAP_SIZE + (unsigned int)x] = color;
+    }
+  }
+}
 
+// Generated levels show the wall window around the camera instead of the
+// whole maze.
+void renderMinimap() {
+  float extent = (float)(MAZE_W > MAZE_H ? MAZE_W : MAZE_H) * CELL_SIZE;
+  minimap_origin_x = 0.0f;
+  minimap_origin_z = 0.0f;
+  if (LEVEL.w) {
+    extent = (float)LEVEL_WINDOW * CELL_SIZE;
+    minimap_origin_x = (float)(window_c - LEVEL_WINDOW_RADIUS) * CELL_SIZE;
+    minimap_origin_z = (float)(window_r - LEVEL_WINDOW_RADIUS) * CELL_SIZE;
+  }
+  minimap_scale = (float)MINIMAP_SIZE / extent;
+
+  unsigned int floor = argb_to_rgba(0xff1e293b);
+  unsigned int border = argb_to_rgba(0xff334155);
+  unsigned int i;
+  for (i = 0; i < MINIMAP_SIZE * MINIMAP_SIZE; i++)
+    MINIMAP[i] = floor;
+  int w;
+  for (w = 0; w < WALL_COUNT; w++) {
+    const Wall *wall = &SCENE_WALLS[w];
+    fillMinimapRect(wall->minx, wall->minz, wall->maxx, wall->maxz,
+                    argb_to_rgba(wall->color));
+  }
+  for (i = 0; i < MINIMAP_SIZE; i++) {
+    MINIMAP[i] = border;
+    MINIMAP[(MINIMAP_SIZE - 1) * MINIMAP_SIZE + i] = border;
+    MINIMAP[i * MINIMAP_SIZE] = border;
+    MINIMAP[i * MINIMAP_SIZE + MINIMAP_SIZE - 1] = border;
+  }
+  MINIMAP_DIRTY = 0;
+}
+
+void drawMinimap() {
+  if (MINIMAP_DIRTY)
+    renderMinimap();
+
+  // Row copies compile to memory.copy with bulk memory enabled. Like plot(),
+  // the minimap clears the depth under it.
+  unsigned int y, x;
+  for (y = 0; y < MINIMAP_SIZE; y++) {
+    unsigned int row = (MINIMAP_MARGIN + y) * WIDTH + MINIMAP_MARGIN;
+    __builtin_memcpy(&BUFFER[row], &MINIMAP[y * MINIMAP_SIZE],
+                     MINIMAP_SIZE * sizeof(unsigned int));
+    for (x = 0; x < MINIMAP_SIZE; x++)
+      DEPTH[row + x] = DEPTH_CLEAR;
+  }
+
+  // Player marker and a 90 degree view cone matching the projection.
+  int px = (int)MINIMAP_MARGIN +
+           (int)((camera_pos.x - minimap_origin_x) * minimap_scale);
+  int py = (int)MINIMAP_MARGIN +
+           (int)((camera_pos.z - minimap_origin_z) * minimap_scale);
+  float reach = 12.0f * 0.7071f;
+  float lx = (VIEW.fwd_x - VIEW.right_x) * reach;
+  float lz = (VIEW.fwd_z - VIEW.right_z) * reach;
+  float rx = (VIEW.fwd_x + VIEW.right_x) * reach;
+  float rz = (VIEW.fwd_z + VIEW.right_z) * reach;
+  unsigned int cone = argb_to_rgba(0xff94a3b8);
+  drawLine(px, py, px + (int)lx, py + (int)lz, cone);
+  drawLine(px, py, px + (int)rx, py + (int)rz, cone);
+  unsigned int marker = argb_to_rgba(0xfffacc15);
+  int dx, dy;
+  for (dy = -1; dy <= 1; dy++) {
+    for (dx = -1; dx <= 1; dx++) {
+      plot(px + dx, py + dy, marker);
+    }
+  }
+}
+
+// Screen-space overlays, drawn last so nothing in the world covers them. Also
+// completes interlaced frames, so call it once per frame after the world.
+void drawHud() {
+  resolveTemporalFrame();
+  drawMinimap();
   drawCrosshair();
 }
+
+// --------- Trace replay ---------
+// Replays a trace copied into TRACE_FILE: restores the starting player state,
+// then replayTraceFrame() runs one recorded frame through the same
+// showCanvas()/drawHud() path with the trace's point lights. JS-owned
+// instances are not part of a trace and are left out, so browser and headless
+// replays of one build hash the same frames.
+static const TraceFrame *trace_replay = 0;
+static unsigned int trace_replay_count = 0;
+static unsigned int trace_replay_pos = 0;
+static int trace_replay_lights = 0;
+
+int traceCapacity() { return (int)sizeof(TRACE_FILE); }
+
+// Returns the number of frames, or -1 if TRACE_FILE does not hold a trace of
+// `bytes` bytes in this version.
+int loadTrace(int bytes) {
+  TraceHeader h;
+  trace_replay_count = 0;
+  if (bytes < (int)sizeof(h) || bytes > (int)sizeof(TRACE_FILE))
+    return -1;
+  __builtin_memcpy(&h, TRACE_FILE, sizeof(h));
+  if (h.magic != TRACE_MAGIC || h.version != TRACE_VERSION ||
+      h.frame_count > TRACE_CAPACITY ||
+      (unsigned int)h.light_count > MAX_LIGHTS ||
+      (unsigned int)bytes != sizeof(h) + h.frame_count * sizeof(TraceFrame))
+    return -1;
+  TRACE_RECORDING = 0;
+  if (!sameLevel(&h.level, &LEVEL) &&
+      !generateMaze(h.level.seed, h.level.w, h.level.h, h.level.braid))
+    return -1;
+  camera_pos = h.start.pos;
+  camera_yaw = h.start.yaw;
+  camera_pitch = h.start.pitch;
+  player_y = h.start.player_y;
+  player_y_vel = h.start.player_y_vel;
+  player_grounded = h.start.grounded;
+  setTemporalMode(0);
+  temporal_frame = h.start.temporal_frame;
+  __builtin_memcpy(LIGHTS, h.lights,
+                   (unsigned int)h.light_count * sizeof(PointLight));
+  trace_replay_lights = h.light_count;
+  trace_replay = (const TraceFrame *)(TRACE_FILE + sizeof(h));
+  trace_replay_count = h.frame_count;
+  trace_replay_pos = 0;
+  return (int)h.frame_count;
+}
+
+// Renders the next frame of the loaded trace. Returns 0 once it is done.
+int replayTraceFrame() {
+  if (trace_replay_pos >= trace_replay_count)
+    return 0;
+  // Recording dropped the interlacing history at every chunk start.
+  if (trace_replay_pos % TRACE_CHUNK_FRAMES == 0)
+    history_valid = 0;
+  const TraceFrame *f = &trace_replay[trace_replay_pos++];
+  setInput(f->keys, f->mouse_dx, f->mouse_dy);
+  setLights(trace_replay_lights, (f->modes & TRACE_MODE_FLASHLIGHT) != 0);
+  int temporal = (f->modes & TRACE_MODE_TEMPORAL) != 0;
+  if (temporal != TEMPORAL_MODE)
+    setTemporalMode(temporal);
+  showCanvas();
+  drawHud();
+  return 1;
+}
+
+// 32-bit FNV-1a over the frame's bytes.
+unsigned int frameHash() {
+  const unsigned char *p = (const unsigned char *)BUFFER;
+  unsigned int h = 2166136261u;
+  unsigned int i;
+  for (i = 0; i < PIXEL_COUNT * 4u; i++) {
+    h ^= p[i];
+    h *= 16777619u;
+  }
+  return h;
+}
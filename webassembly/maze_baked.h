@@ -0,0 +1,168 @@
+// Generated by bake_maze from MAZE in graphics.c. Do not edit;
+// run `make maze_baked.h` after changing the maze or builder.
+#define BAKED_WALL_COUNT 50
+
+static const Wall BAKED_WALLS[50] = {
+    {0.0f, 0.0f, 2.0f, 2.0f, 1.6f, 0xff475569u, 0x1eu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {2.0f, 0.0f, 4.0f, 2.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{89, 179, 255, 166}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 89, 166, 255}, {179, 255, 255, 179}}},
+    {4.0f, 0.0f, 6.0f, 2.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {6.0f, 0.0f, 8.0f, 2.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {8.0f, 0.0f, 10.0f, 2.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {10.0f, 0.0f, 12.0f, 2.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{179, 89, 166, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 166, 89}}},
+    {12.0f, 0.0f, 14.0f, 2.0f, 1.6f, 0xff475569u, 0x0eu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {14.0f, 0.0f, 16.0f, 2.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{89, 89, 166, 166}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 89, 166, 255}, {179, 255, 166, 89}}},
+    {16.0f, 0.0f, 18.0f, 2.0f, 1.6f, 0xff475569u, 0x2eu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {0.0f, 2.0f, 2.0f, 4.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 166, 89}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {89, 166, 255, 179}}},
+    {12.0f, 2.0f, 14.0f, 4.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {89, 166, 166, 89}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {89, 179, 255, 166}, {89, 166, 255, 179}}},
+    {16.0f, 2.0f, 18.0f, 4.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {89, 166, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {89, 179, 255, 166}, {179, 255, 255, 179}}},
+    {0.0f, 4.0f, 2.0f, 6.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {4.0f, 4.0f, 6.0f, 6.0f, 1.6f, 0xff475569u, 0x1eu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {6.0f, 4.0f, 8.0f, 6.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{89, 179, 255, 166}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 89, 166, 255}, {179, 255, 255, 179}}},
+    {8.0f, 4.0f, 10.0f, 6.0f, 1.6f, 0xff475569u, 0x2fu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {12.0f, 4.0f, 14.0f, 6.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {16.0f, 4.0f, 18.0f, 6.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {0.0f, 6.0f, 2.0f, 8.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {4.0f, 6.0f, 6.0f, 8.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 166, 89}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {89, 166, 255, 179}}},
+    {12.0f, 6.0f, 14.0f, 8.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{89, 179, 255, 166}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 89, 166, 255}, {179, 255, 255, 179}}},
+    {16.0f, 6.0f, 18.0f, 8.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {0.0f, 8.0f, 2.0f, 10.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {4.0f, 8.0f, 6.0f, 10.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {8.0f, 8.0f, 10.0f, 10.0f, 1.6f, 0xff475569u, 0x1eu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {10.0f, 8.0f, 12.0f, 10.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{89, 179, 255, 166}, {179, 255, 166, 89}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 89, 166, 255}, {89, 166, 255, 179}}},
+    {12.0f, 8.0f, 14.0f, 10.0f, 1.6f, 0xff475569u, 0x2du,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {16.0f, 8.0f, 18.0f, 10.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {0.0f, 10.0f, 2.0f, 12.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {4.0f, 10.0f, 6.0f, 12.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {8.0f, 10.0f, 10.0f, 12.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 166, 89}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {89, 166, 255, 179}}},
+    {16.0f, 10.0f, 18.0f, 12.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{89, 179, 255, 166}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 89, 166, 255}, {179, 255, 255, 179}}},
+    {0.0f, 12.0f, 2.0f, 14.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {4.0f, 12.0f, 6.0f, 14.0f, 1.6f, 0xff475569u, 0x3du,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {8.0f, 12.0f, 10.0f, 14.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {12.0f, 12.0f, 14.0f, 14.0f, 1.6f, 0xff475569u, 0x1fu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {14.0f, 12.0f, 16.0f, 14.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{179, 89, 166, 255}, {179, 255, 166, 89}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {89, 166, 166, 89}}},
+    {16.0f, 12.0f, 18.0f, 14.0f, 1.6f, 0xff475569u, 0x2cu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {0.0f, 14.0f, 2.0f, 16.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{179, 89, 166, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 166, 89}}},
+    {8.0f, 14.0f, 10.0f, 16.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{89, 89, 166, 166}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 89, 166, 255}, {179, 255, 166, 89}}},
+    {16.0f, 14.0f, 18.0f, 16.0f, 1.6f, 0xff475569u, 0x3cu,
+     {{89, 179, 255, 166}, {89, 166, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {89, 89, 166, 166}, {179, 255, 255, 179}}},
+    {0.0f, 16.0f, 2.0f, 18.0f, 1.6f, 0xff475569u, 0x1du,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {2.0f, 16.0f, 4.0f, 18.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{179, 179, 255, 255}, {89, 166, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {89, 179, 255, 166}, {179, 255, 255, 179}}},
+    {4.0f, 16.0f, 6.0f, 18.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {6.0f, 16.0f, 8.0f, 18.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{179, 179, 255, 255}, {179, 255, 166, 89}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {89, 166, 255, 179}}},
+    {8.0f, 16.0f, 10.0f, 18.0f, 1.6f, 0xff475569u, 0x0du,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {10.0f, 16.0f, 12.0f, 18.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{179, 179, 255, 255}, {89, 166, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {89, 179, 255, 166}, {179, 255, 255, 179}}},
+    {12.0f, 16.0f, 14.0f, 18.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+    {14.0f, 16.0f, 16.0f, 18.0f, 1.6f, 0xff475569u, 0x0fu,
+     {{179, 179, 255, 255}, {179, 255, 166, 89}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {89, 166, 255, 179}}},
+    {16.0f, 16.0f, 18.0f, 18.0f, 1.6f, 0xff475569u, 0x2du,
+     {{179, 179, 255, 255}, {179, 255, 255, 179}, {255, 255, 255, 255},
+      {255, 255, 255, 255}, {179, 179, 255, 255}, {179, 255, 255, 179}}},
+};
+
+static const short BAKED_WALL_GRID[9][9] = {
+    {0, 1, 2, 3, 4, 5, 6, 7, 8},
+    {9, -1, -1, -1, -1, -1, 10, -1, 11},
+    {12, -1, 13, 14, 15, -1, 16, -1, 17},
+    {18, -1, 19, -1, -1, -1, 20, -1, 21},
+    {22, -1, 23, -1, 24, 25, 26, -1, 27},
+    {28, -1, 29, -1, 30, -1, -1, -1, 31},
+    {32, -1, 33, -1, 34, -1, 35, 36, 37},
+    {38, -1, -1, -1, 39, -1, -1, -1, 40},
+    {41, 42, 43, 44, 45, 46, 47, 48, 49},
+};
@@ -0,0 +1,130 @@
+// Headless replay of an input trace recorded in the browser (R in the demo).
+// Runs every frame through the same showCanvas()/drawHud() path as the page
+// and prints one TSV row per frame, plus a summary on stderr:
+//
+//   frame  ms  hash
+//
+//   replay trace.mztr
+//   replay --check      record a scripted interlaced walk over several chunks,
+//                       replay it and compare every frame with the live one
+#include "graphics.c"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static double nowMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec * 1e-6;
+}
+
+#define CHECK_FRAMES (TRACE_CHUNK_FRAMES * 2u + 552u)
+
+#define CHECK_LIGHTS 4
+
+// Scripted input: walk and turn, strafe and jump now and then, and toggle the
+// flashlight and interlacing so frames of every mode cross chunk starts.
+static void checkInput(unsigned int i) {
+  int keys = i % 200u < 150u ? 1 : 4;
+  if (i % 90u < 20u)
+    keys |= 8;
+  if (i % 300u == 0u)
+    keys |= 16;
+  setInput(keys, i % 60u < 30u ? 2 : -2, i % 40u < 20u ? 1 : -1);
+  setLights(CHECK_LIGHTS, i % 700u >= 500u);
+  // setTemporalMode() drops the history, so only call it on a change.
+  int temporal = i % 1500u < 1400u;
+  if (temporal != TEMPORAL_MODE)
+    setTemporalMode(temporal);
+}
+
+static int check() {
+  static unsigned int live[CHECK_FRAMES];
+  unsigned int i;
+  for (i = 0; i < CHECK_LIGHTS; i++) { // the page's pickup glows
+    PointLight l = {3.0f + 4.0f * (float)i, 0.6f, 3.0f + 2.0f * (float)i,
+                    2.5f, 0.7f, 0xfffbbf24u};
+    LIGHTS[i] = l;
+  }
+  setTemporalMode(1);
+  for (i = 0; i < 37u; i++) { // leave history and parity mid-stream
+    checkInput(i);
+    showCanvas();
+    drawHud();
+  }
+  startTraceRecording();
+  for (i = 0; i < CHECK_FRAMES; i++) {
+    checkInput(i);
+    showCanvas();
+    drawHud();
+    live[i] = frameHash();
+  }
+  stopTraceRecording();
+  int bytes = exportTrace();
+  __builtin_memset(LIGHTS, 0, sizeof(LIGHTS)); // the trace must bring them
+  int frames = loadTrace(bytes);
+  if (frames != (int)CHECK_FRAMES) {
+    fprintf(stderr, "replay --check: exported %d of %u frames\n", frames,
+            CHECK_FRAMES);
+    return 1;
+  }
+  unsigned int differ = 0, first = CHECK_FRAMES;
+  for (i = 0; i < CHECK_FRAMES; i++) {
+    replayTraceFrame();
+    if (frameHash() != live[i]) {
+      if (!differ)
+        first = i;
+      differ++;
+    }
+  }
+  if (differ) {
+    fprintf(stderr, "replay --check: %u of %u frames differ, first %u\n",
+            differ, CHECK_FRAMES, first);
+    return 1;
+  }
+  fprintf(stderr, "replay --check: %u frames match the live run\n",
+          CHECK_FRAMES);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  if (argc == 2 && strcmp(argv[1], "--check") == 0)
+    return check();
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s trace.mztr | --check\n", argv[0]);
+    return 2;
+  }
+  FILE *f = fopen(argv[1], "rb");
+  if (!f) {
+    perror(argv[1]);
+    return 1;
+  }
+  size_t bytes = fread(TRACE_FILE, 1, sizeof(TRACE_FILE), f);
+  int extra = fgetc(f) != EOF;
+  fclose(f);
+  int frames = extra ? -1 : loadTrace((int)bytes);
+  if (frames < 0) {
+    fprintf(stderr, "%s: not a version %u trace\n", argv[1], TRACE_VERSION);
+    return 1;
+  }
+
+  double total = 0.0, worst = 0.0;
+  unsigned int combined = 2166136261u;
+  int i;
+  printf("frame\tms\thash\n");
+  for (i = 0; i < frames; i++) {
+    double start = nowMs();
+    replayTraceFrame();
+    double ms = nowMs() - start;
+    unsigned int hash = frameHash();
+    printf("%d\t%.3f\t%08x\n", i, ms, hash);
+    total += ms;
+    if (ms > worst)
+      worst = ms;
+    combined = (combined ^ hash) * 16777619u;
+  }
+  fprintf(stderr, "%d frames, %.3f ms/frame mean, %.3f ms worst, hash %08x\n",
+          frames, frames ? total / frames : 0.0, worst, combined);
+  return 0;
+}